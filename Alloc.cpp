@@ -0,0 +1,136 @@
+#include "Alloc.h"
+#include "Game.h"
+#include "Player.h"
+#include <new>
+#include <cstdlib>
+
+using namespace std;
+
+namespace
+{
+    //Plain thread_local arrays, so counting never needs to allocate
+    thread_local AllocationCounts counts[NALLOCPHASES];
+    thread_local AllocationPhase currentPhase = ALLOC_OTHER;
+}
+
+bool allocationCountingCompiledIn()
+{
+#ifdef BATTLESHIP_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationCounts threadAllocations(AllocationPhase phase)
+{
+    return counts[phase];
+}
+
+AllocationScope::AllocationScope(AllocationPhase phase)
+ : m_previous(currentPhase)
+{
+    currentPhase = phase;
+}
+
+AllocationScope::~AllocationScope()
+{
+    currentPhase = m_previous;
+}
+
+long long steadyStateAllocations(Game& g, const string& typeA, const string& typeB,
+                                 int warmupGames, int games)
+{
+    long long before = 0;
+    GameRecord record;
+    for (int k = 0; k < warmupGames + games; k++)
+    {
+        if (k == warmupGames)
+            before = counts[ALLOC_PLAY].allocations;
+        if (playKnownPairing(typeA, typeB, g, record))
+            continue;
+        Player* a = createPlayer(typeA, typeA, g);
+        Player* b = createPlayer(typeB, typeB, g);
+        if (a != nullptr  &&  b != nullptr)
+            g.playQuietly(a, b, &record);
+        delete a;
+        delete b;
+    }
+    return counts[ALLOC_PLAY].allocations - before;
+}
+
+#ifdef BATTLESHIP_COUNT_ALLOCATIONS
+
+//******************** Counting operator new and delete ********************************
+
+//malloc doesn't count, so the counters themselves can never recurse
+static void* countedAlloc(size_t size)
+{
+    AllocationCounts& c = counts[currentPhase];
+    c.allocations++;
+    c.bytes += (long long)(size);
+    return malloc(size == 0 ? 1 : size);
+}
+
+static void countedFree(void* p)
+{
+    if (p == nullptr)
+        return;
+    counts[currentPhase].frees++;
+    free(p);
+}
+
+void* operator new(size_t size)
+{
+    void* p = countedAlloc(size);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+#endif // BATTLESHIP_COUNT_ALLOCATIONS
@@ -0,0 +1,56 @@
+#ifndef ALLOC_INCLUDED
+#define ALLOC_INCLUDED
+
+#include <string>
+
+class Game;
+
+  // Counts of the heap allocations made by each thread, split by what the
+  // thread was doing at the time.  Counting is only done when the program
+  // is compiled with BATTLESHIP_COUNT_ALLOCATIONS defined, which replaces
+  // the global operator new and operator delete with counting versions;
+  // otherwise every count stays 0 and allocationCountingCompiledIn()
+  // returns false.
+
+enum AllocationPhase
+{
+    ALLOC_OTHER,      // anything not inside a game
+    ALLOC_SETUP,      // creating players and boards and placing ships
+    ALLOC_PLAY,       // the turns of a game
+    NALLOCPHASES
+};
+
+struct AllocationCounts
+{
+    long long allocations;
+    long long frees;
+    long long bytes;     // total requested by those allocations
+};
+
+bool allocationCountingCompiledIn();
+
+  // What the calling thread has allocated in the given phase so far
+AllocationCounts threadAllocations(AllocationPhase phase);
+
+  // Counts the calling thread's allocations under phase until destroyed,
+  // then goes back to counting under the phase before it
+class AllocationScope
+{
+  public:
+    AllocationScope(AllocationPhase phase);
+    ~AllocationScope();
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+  private:
+    AllocationPhase m_previous;
+};
+
+  // Play warmupGames and then games more quiet games on g between
+  // computer player types typeA and typeB, in the calling thread, and
+  // return how many allocations the turns of the later games made.  A
+  // warmed-up game should make none.
+long long steadyStateAllocations(Game& g, const std::string& typeA,
+                                 const std::string& typeB, int warmupGames, int games);
+
+#endif // ALLOC_INCLUDED
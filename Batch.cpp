@@ -0,0 +1,199 @@
+#include "Batch.h"
+#include "Game.h"
+#include "Player.h"
+#include "Fleet.h"
+#include "Board.h"
+#include "Columns.h"
+#include "Replay.h"
+#include "Trace.h"
+#include "globals.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct ShipLine
+    {
+        int line;
+        int length;
+        char symbol;
+        string name;
+    };
+
+    //Everything after the first # is a comment
+    string stripComment(const string& line)
+    {
+        size_t hash = line.find('#');
+        return hash == string::npos ? line : line.substr(0, hash);
+    }
+
+    //A type the batch can play: one createPlayer knows, with no human at the keyboard
+    bool checkType(const string& type, const Game& g, string& error)
+    {
+        Player* p = createPlayer(type, type, g);
+        bool ok = (p != nullptr  &&  !p->isHuman());
+        delete p;
+        if (!ok)
+            error = "\"" + type + "\" is not a computer player type";
+        return ok;
+    }
+}
+
+bool readBatchJob(istream& in, BatchJob& job, string& error)
+{
+    vector<ShipLine> ships;
+    string text;
+    for (int lineNumber = 1; getline(in, text); lineNumber++)
+    {
+        istringstream line(stripComment(text));
+        string keyword;
+        if (!(line >> keyword))
+            continue;
+        MatchOptions& m = job.match;
+        bool ok;
+        if (keyword == "board")
+            ok = bool(line >> m.rows >> m.cols);
+        else if (keyword == "ship")
+        {
+            ShipLine ship;
+            ship.line = lineNumber;
+            ok = bool(line >> ship.length >> ship.symbol);
+            getline(line >> ws, ship.name);
+            ships.push_back(ship);
+        }
+        else if (keyword == "players")
+            ok = bool(line >> m.typeA >> m.typeB);
+        else if (keyword == "games")
+            ok = bool(line >> m.nGames)  &&  m.nGames >= 0;
+        else if (keyword == "threads")
+            ok = bool(line >> m.nThreads)  &&  m.nThreads >= 0;
+        else if (keyword == "seed")
+            ok = bool(line >> m.seed);
+        else if (keyword == "salvo")
+        {
+            m.salvo = true;
+            ok = bool(line >> m.salvoShots)  &&  m.salvoShots >= 0;
+        }
+        else if (keyword == "limits")
+            ok = bool(line >> m.limits.maxTurns >> m.limits.maxWasted >> m.limits.maxMillis);
+        else if (keyword == "report")
+            ok = bool(line >> job.reportEvery)  &&  job.reportEvery >= 0;
+        else if (keyword == "trace")
+            ok = bool(line >> job.tracePath);
+        else if (keyword == "columns")
+            ok = bool(line >> job.columnsPath);
+        else if (keyword == "replay")
+            ok = bool(line >> job.replayPath);
+        else if (keyword == "checkpoint")
+            ok = bool(line >> m.checkpointPath);
+        else if (keyword == "shard")
+            ok = bool(line >> m.shardIndex >> m.shardCount >> job.shardResultPath)  &&
+                 m.shardCount >= 1  &&  m.shardIndex >= 0  &&  m.shardIndex < m.shardCount;
+        else
+        {
+            error = "line " + to_string(lineNumber) + ": unknown keyword \"" + keyword + "\"";
+            return false;
+        }
+        string extra;
+        if (!ok  ||  line >> extra)
+        {
+            error = "line " + to_string(lineNumber) + ": bad " + keyword + " line";
+            return false;
+        }
+    }
+
+    //Build the fleet once; every game of the job shares it
+    MatchOptions& m = job.match;
+    if (m.rows < 1  ||  m.rows > MAXROWS  ||  m.cols < 1  ||  m.cols > MAXCOLS)
+    {
+        error = "the board must be at most " + to_string(MAXROWS) + " by " + to_string(MAXCOLS);
+        return false;
+    }
+    if (ships.empty())
+    {
+        error = "the spec has no ships";
+        return false;
+    }
+    Game g(m.rows, m.cols);
+    for (size_t s = 0; s < ships.size(); s++)
+        if (!g.addShip(ships[s].length, ships[s].symbol, ships[s].name))
+        {
+            error = "line " + to_string(ships[s].line) + ": the ship can't be added";
+            return false;
+        }
+    if (m.salvo  &&  (m.salvoShots > m.rows * m.cols  ||  m.salvoShots > MAXSALVO))
+    {
+        error = "a salvo can be at most " + to_string(min(m.rows * m.cols, MAXSALVO)) +
+                " shots on this board";
+        return false;
+    }
+    if (!checkType(m.typeA, g, error)  ||  !checkType(m.typeB, g, error))
+        return false;
+    m.fleet = g.catalog();
+    m.addShips = nullptr;
+    return true;
+}
+
+int runBatchJob(const BatchJob& job, ostream& out)
+{
+    MatchOptions options = job.match;
+    if (job.reportEvery > 0)
+    {
+        options.progressEvery = job.reportEvery;
+        options.progress = [&out, &options](const MatchStats& stats) {
+            out << stats.games() << " games: " << options.typeA << " won " << stats.wins(0)
+                << ", " << options.typeB << " won " << stats.wins(1)
+                << " (win rate " << stats.winRate() << ")" << endl;
+        };
+    }
+    ColumnWriter columns;
+    if (!job.columnsPath.empty())
+    {
+        if (!columns.open(job.columnsPath, options.fleet->nShips()))
+        {
+            out << "Could not create " << job.columnsPath << endl;
+            return 1;
+        }
+        options.columns = &columns;
+    }
+    ReplayWriter replay;
+    if (!job.replayPath.empty())
+    {
+        if (!replay.open(job.replayPath, Game(options.fleet)))
+        {
+            out << "Could not create " << job.replayPath << endl;
+            return 1;
+        }
+        options.replay = &replay;
+    }
+    if (!job.tracePath.empty()  &&  !traceCompiledIn())
+        out << "Not tracing: this program was compiled without BATTLESHIP_TRACE" << endl;
+    MatchStats stats = runMatch(options);
+    stats.print(out, options.typeA, options.typeB, options.fleet->nShips());
+    if (!job.tracePath.empty()  &&  traceCompiledIn()  &&  !writeChromeTrace(job.tracePath))
+    {
+        out << "Could not write " << job.tracePath << endl;
+        return 1;
+    }
+    if (!columns.close())
+    {
+        out << "Could not write " << job.columnsPath << endl;
+        return 1;
+    }
+    if (!job.replayPath.empty()  &&  !replay.close())
+    {
+        out << "Could not write " << job.replayPath << endl;
+        return 1;
+    }
+    if (!job.shardResultPath.empty()  &&
+        !writeShardResult(job.shardResultPath, options, stats))
+    {
+        out << "Could not write " << job.shardResultPath << endl;
+        return 1;
+    }
+    return 0;
+}
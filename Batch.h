@@ -0,0 +1,53 @@
+#ifndef BATCH_INCLUDED
+#define BATCH_INCLUDED
+
+#include "Tournament.h"
+#include <string>
+#include <iosfwd>
+
+  // A match described by a job spec instead of code.  A spec is a text
+  // file of lines "keyword value..."; blank lines and anything after a #
+  // are ignored.  The keywords are
+  //
+  //   board <rows> <cols>          board size (default 10 10)
+  //   ship <length> <symbol> <name...>
+  //                                a ship, added with Game::addShip; one
+  //                                line per ship, in order
+  //   players <typeA> <typeB>      createPlayer types (default good mediocre)
+  //   games <n>                    number of games (default 50)
+  //   threads <n>                  0 for one per hardware thread (default)
+  //   seed <n>                     match seed (default 1)
+  //   salvo <shots>                play salvo games, 0 for one shot per ship afloat;
+  //                                at most MAXSALVO and the number of cells
+  //   limits <turns> <wasted> <milliseconds>
+  //                                GameLimits, 0 for none
+  //   report <n>                   print running totals every n games; this
+  //                                doesn't change how often checkpoints are saved
+  //   checkpoint <file>            save progress here and resume from it
+  //   shard <index> <count> <file> play one shard, saving its result in file
+  //   columns <file>               write every game's result to a columnar
+  //                                results file (see Columns.h)
+  //   replay <file>                record every game, shot by shot, in a
+  //                                replay file (see Replay.h)
+  //   trace <file>                 write a Chrome trace of the run (only if
+  //                                compiled with BATTLESHIP_TRACE; see Trace.h)
+struct BatchJob
+{
+    MatchOptions match;
+    long long reportEvery = 0;
+    std::string shardResultPath;
+    std::string columnsPath;
+    std::string replayPath;
+    std::string tracePath;
+};
+
+  // Read a job spec.  The ships are added to a Game as the spec is read,
+  // so the fleet is checked and its catalog built once, up front.  Returns
+  // false, with the line and problem in error, if the spec is bad.
+bool readBatchJob(std::istream& in, BatchJob& job, std::string& error);
+
+  // Run the job at full speed, writing running totals as they come in and
+  // then the final statistics to out.  Returns 0 on success.
+int runBatchJob(const BatchJob& job, std::ostream& out);
+
+#endif // BATCH_INCLUDED
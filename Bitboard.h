@@ -0,0 +1,202 @@
+#ifndef BITBOARD_INCLUDED
+#define BITBOARD_INCLUDED
+
+#include "globals.h"
+#include <cstdint>
+
+const int MAXCELLS = MAXROWS * MAXCOLS;
+
+  // Cell (r,c) of the grid is numbered r*MAXCOLS+c, whatever the size of
+  // the game's board, so moving one column is +1 and one row is +MAXCOLS.
+inline int cellIndex(Point p)
+{
+    return p.r * MAXCOLS + p.c;
+}
+
+inline Point cellPoint(int index)
+{
+    return Point(index / MAXCOLS, index % MAXCOLS);
+}
+
+  // A set of cells, one bit per cell of a MAXROWS x MAXCOLS grid
+class Bitboard
+{
+  public:
+    Bitboard() : m_lo(0), m_hi(0) {}
+    Bitboard(std::uint64_t lo, std::uint64_t hi) : m_lo(lo), m_hi(hi) {}
+
+    static Bitboard cell(int index)
+    {
+        return index < 64 ? Bitboard(std::uint64_t(1) << index, 0)
+                          : Bitboard(0, std::uint64_t(1) << (index - 64));
+    }
+    static Bitboard cell(Point p) { return cell(cellIndex(p)); }
+
+      // All the cells of a board with the given number of rows and columns
+    static Bitboard area(int nRows, int nCols)
+    {
+        Bitboard b;
+        for (int r = 0; r < nRows; r++)
+            for (int c = 0; c < nCols; c++)
+                b.set(r * MAXCOLS + c);
+        return b;
+    }
+
+    std::uint64_t lo() const { return m_lo; }
+    std::uint64_t hi() const { return m_hi; }
+
+    bool test(int index) const
+    {
+        return index < 64 ? (m_lo >> index) & 1 : (m_hi >> (index - 64)) & 1;
+    }
+    bool test(Point p) const { return test(cellIndex(p)); }
+    void set(int index) { *this |= cell(index); }
+    void reset(int index) { *this &= ~cell(index); }
+
+    bool any() const { return (m_lo | m_hi) != 0; }
+    bool none() const { return (m_lo | m_hi) == 0; }
+    int count() const { return popCount(m_lo) + popCount(m_hi); }
+
+      // Index of the lowest numbered cell in the set, or -1 if it's empty
+    int lowest() const
+    {
+        if (m_lo != 0)
+            return trailingZeros(m_lo);
+        if (m_hi != 0)
+            return 64 + trailingZeros(m_hi);
+        return -1;
+    }
+
+      // Remove the lowest numbered cell from the set and return its index
+    int popLowest()
+    {
+        int index = lowest();
+        if (m_lo != 0)
+            m_lo &= m_lo - 1;
+        else
+            m_hi &= m_hi - 1;
+        return index;
+    }
+
+      // True if every cell of other is also in this set
+    bool contains(const Bitboard& other) const
+    {
+        return (other.m_lo & ~m_lo) == 0  &&  (other.m_hi & ~m_hi) == 0;
+    }
+    bool intersects(const Bitboard& other) const
+    {
+        return ((m_lo & other.m_lo) | (m_hi & other.m_hi)) != 0;
+    }
+
+      // Every cell moved dr rows down and dc columns right; cells moved off
+      // the MAXROWS x MAXCOLS grid are dropped
+    Bitboard shifted(int dr, int dc) const
+    {
+        if (dr <= -MAXROWS  ||  dr >= MAXROWS  ||  dc <= -MAXCOLS  ||  dc >= MAXCOLS)
+            return Bitboard();
+        //Cells that would wrap into the next or previous row go first
+        Bitboard b = *this & shiftKeep(dr, dc);
+        int n = dr * MAXCOLS + dc;
+        return n >= 0 ? b.shiftedUp(n) : b.shiftedDown(-n);
+    }
+
+    std::uint64_t hash() const
+    {
+        std::uint64_t h = m_lo * 0x9E3779B97F4A7C15ULL;
+        h ^= (m_hi + 0x632BE59BD9B4E019ULL) * 0xC2B2AE3D27D4EB4FULL;
+        return h ^ (h >> 29);
+    }
+
+    Bitboard operator~() const { return Bitboard(~m_lo, ~m_hi); }
+    Bitboard& operator|=(const Bitboard& o) { m_lo |= o.m_lo; m_hi |= o.m_hi; return *this; }
+    Bitboard& operator&=(const Bitboard& o) { m_lo &= o.m_lo; m_hi &= o.m_hi; return *this; }
+    Bitboard& operator^=(const Bitboard& o) { m_lo ^= o.m_lo; m_hi ^= o.m_hi; return *this; }
+    friend Bitboard operator|(Bitboard a, const Bitboard& b) { return a |= b; }
+    friend Bitboard operator&(Bitboard a, const Bitboard& b) { return a &= b; }
+    friend Bitboard operator^(Bitboard a, const Bitboard& b) { return a ^= b; }
+    friend bool operator==(const Bitboard& a, const Bitboard& b)
+    {
+        return a.m_lo == b.m_lo  &&  a.m_hi == b.m_hi;
+    }
+    friend bool operator!=(const Bitboard& a, const Bitboard& b) { return !(a == b); }
+    friend bool operator<(const Bitboard& a, const Bitboard& b)
+    {
+        return a.m_hi != b.m_hi ? a.m_hi < b.m_hi : a.m_lo < b.m_lo;
+    }
+
+  private:
+    std::uint64_t m_lo;  // cells 0 through 63
+    std::uint64_t m_hi;  // cells 64 through MAXCELLS-1
+
+      // The cells that stay on the grid when moved dr rows and dc columns,
+      // for every move shifted allows, worked out once
+    struct ShiftKeepTable
+    {
+        std::uint64_t lo[2 * MAXROWS - 1][2 * MAXCOLS - 1];
+        std::uint64_t hi[2 * MAXROWS - 1][2 * MAXCOLS - 1];
+        ShiftKeepTable()
+        {
+            for (int dr = 1 - MAXROWS; dr < MAXROWS; dr++)
+                for (int dc = 1 - MAXCOLS; dc < MAXCOLS; dc++)
+                {
+                    Bitboard keep;
+                    for (int r = 0; r < MAXROWS; r++)
+                        for (int c = 0; c < MAXCOLS; c++)
+                            if (r + dr >= 0  &&  r + dr < MAXROWS  &&
+                                                    c + dc >= 0  &&  c + dc < MAXCOLS)
+                                keep.set(r * MAXCOLS + c);
+                    lo[dr + MAXROWS - 1][dc + MAXCOLS - 1] = keep.m_lo;
+                    hi[dr + MAXROWS - 1][dc + MAXCOLS - 1] = keep.m_hi;
+                }
+        }
+    };
+    static Bitboard shiftKeep(int dr, int dc)
+    {
+        static const ShiftKeepTable table;
+        return Bitboard(table.lo[dr + MAXROWS - 1][dc + MAXCOLS - 1],
+                        table.hi[dr + MAXROWS - 1][dc + MAXCOLS - 1]);
+    }
+
+      // The whole 128 bits shifted toward higher or lower cell numbers
+    Bitboard shiftedUp(int n) const
+    {
+        if (n == 0)
+            return *this;
+        if (n >= 64)
+            return Bitboard(0, m_lo << (n - 64));
+        return Bitboard(m_lo << n, (m_hi << n) | (m_lo >> (64 - n)));
+    }
+    Bitboard shiftedDown(int n) const
+    {
+        if (n == 0)
+            return *this;
+        if (n >= 64)
+            return Bitboard(m_hi >> (n - 64), 0);
+        return Bitboard((m_lo >> n) | (m_hi << (64 - n)), m_hi >> n);
+    }
+
+    static int popCount(std::uint64_t x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+#else
+        int n = 0;
+        for ( ; x != 0; x &= x - 1)
+            n++;
+        return n;
+#endif
+    }
+    static int trailingZeros(std::uint64_t x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(x);
+#else
+        int n = 0;
+        for ( ; (x & 1) == 0; x >>= 1)
+            n++;
+        return n;
+#endif
+    }
+};
+
+#endif // BITBOARD_INCLUDED
@@ -1,7 +1,12 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "Bitboard.h"
+#include "Fleet.h"
+#include "CompactBoard.h"
+#include "Trace.h"
 #include <iostream>
+#include <vector>
 
 using namespace std;
 
@@ -16,43 +21,45 @@ class BoardImpl
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    int attackBatch(const Point* points, int n, SalvoResult& result);
     bool allShipsDestroyed() const;
+    int shipsAfloat() const;
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+    bool snapshot(CompactBoard& out) const;
 
   private:
     const Game& m_game;
     char m_grid[MAXROWS][MAXCOLS];
-    int m_block[MAXROWS][MAXCOLS];
-    bool shipsPlaced[100];
+    Bitboard m_block;
+    std::vector<short> m_placed;  //Per ship, 2*cell+dir of its top or left cell, or -1 if not placed
+    std::vector<Bitboard> m_shipCells;  //Per ship, the cells it covers
+    Bitboard m_fleet;             //Cells covered by any ship
+    Bitboard m_shot;              //Cells attacked so far
+
+    bool isPlaced(int shipId) const;
 };
 
 BoardImpl::BoardImpl(const Game& g)
- : m_game(g)
+ : m_game(g), m_placed(g.nShips(), -1), m_shipCells(g.nShips())
 {
-    // Set the grid to be '.' and m_block to 0. # ships placed should also be all set to false.  
-    for (int r = 0; r < 10; r ++)
-    {
-        for (int c = 0; c < 10; c++)
-        {
+    // Set the grid to be '.'; no cells are blocked and no ships placed
+    for (int r = 0; r < MAXROWS; r ++)
+        for (int c = 0; c < MAXCOLS; c++)
             m_grid[r][c] = '.';
-            m_block[r][c] = 0;
-            shipsPlaced[r*10+c] = false;
-        }
-    }
 }
 
 
 void BoardImpl::clear()
 {
     //Clears board, essentially makes everything back to original
-    for (int r = 0; r < 10; r ++)
-    {
-        for (int c = 0; c < 10; c++)
-        {
+    for (int r = 0; r < MAXROWS; r ++)
+        for (int c = 0; c < MAXCOLS; c++)
             m_grid[r][c] = '.';
-            m_block[r][c] = 0;
-            shipsPlaced[r*10+c] = false;
-        }
-    }
+    m_block = Bitboard();
+    m_placed.assign(m_game.nShips(), -1);
+    m_shipCells.assign(m_game.nShips(), Bitboard());
+    m_fleet = Bitboard();
+    m_shot = Bitboard();
 }
 
 void BoardImpl::block()
@@ -61,18 +68,17 @@ void BoardImpl::block()
     for (int r = 0; r < m_game.rows(); r++)
         for (int c = 0; c < m_game.cols(); c++)
             if (randInt(2) == 0)
-            {
-                m_block[r][c] = 1; //Block contains 1 if that area is to be blocked
-            }
+                m_block.set(cellIndex(Point(r, c)));
 }
 
 void BoardImpl::unblock()
 {
-    for (int r = 0; r < m_game.rows(); r++)
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            m_block[r][c] = 0; //Turns block grid to all 0s
-        }
+    m_block = Bitboard();
+}
+
+bool BoardImpl::isPlaced(int shipId) const
+{
+    return shipId < int(m_placed.size())  &&  m_placed[shipId] >= 0;
 }
 
 bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
@@ -93,28 +99,41 @@ bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
     // if ship is vertical and trying to be placed on blocked location or another ship
     if (dir == VERTICAL)
         for (int r = topOrLeft.r; r < topOrLeft.r + m_game.shipLength(shipId) ; r++)
-            if (m_block[r][topOrLeft.c] == 1 || m_grid[r][topOrLeft.c] != '.')
+            if (m_block.test(cellIndex(Point(r, topOrLeft.c))) || m_grid[r][topOrLeft.c] != '.')
                 return false;
     // if ship is horizontal and trying to be placed on blocked location or another ship
     if (dir == HORIZONTAL)
         for (int c = topOrLeft.c; c < topOrLeft.c + m_game.shipLength(shipId) ; c++)
-            if (m_block[topOrLeft.r][c] == 1 || m_grid[topOrLeft.r][c] != '.')
+            if (m_block.test(cellIndex(Point(topOrLeft.r, c))) || m_grid[topOrLeft.r][c] != '.')
                 return false;
                 
     //If ship has already been placed on the board
-    if (shipsPlaced[shipId])
+    if (isPlaced(shipId))
         return false;
     
     //Ship placed, change board grid to reflect new ship, and return true
-    shipsPlaced[shipId] = true;
+    if (shipId >= int(m_placed.size()))
+    {
+        m_placed.resize(m_game.nShips(), -1);
+        m_shipCells.resize(m_game.nShips());
+    }
+    m_placed[shipId] = short(2 * cellIndex(topOrLeft) + (dir == VERTICAL ? 1 : 0));
+    m_shipCells[shipId] = Bitboard();
     
     //Adds the ship symbol at the right locations on the board, for both Vertical and Horizontal cases
     if (dir == VERTICAL) //Vertical
         for (int r = topOrLeft.r; r < topOrLeft.r + m_game.shipLength(shipId) ; r++)
+        {
             m_grid[r][topOrLeft.c] = m_game.shipSymbol(shipId);
+            m_shipCells[shipId].set(cellIndex(Point(r, topOrLeft.c)));
+        }
     else if (dir == HORIZONTAL) //Horizontal
         for (int c = topOrLeft.c; c < topOrLeft.c + m_game.shipLength(shipId) ; c++)
+        {
             m_grid[topOrLeft.r][c] = m_game.shipSymbol(shipId);
+            m_shipCells[shipId].set(cellIndex(Point(topOrLeft.r, c)));
+        }
+    m_fleet |= m_shipCells[shipId];
     
     return true;
 }
@@ -125,7 +144,7 @@ bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
     if (shipId < 0 || shipId >= m_game.nShips())
         return false;
     // Ship wasn't placed on the board in the first place
-    if (!shipsPlaced[shipId])
+    if (!isPlaced(shipId))
         return false;
     // If the full ship was not there, then cannot be unplaced
     if (dir == VERTICAL){
@@ -140,7 +159,9 @@ bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
     }
     
     //Ship unplaced, replace location of ship with '.', and return true
-    shipsPlaced[shipId] = false;
+    m_placed[shipId] = -1;
+    m_fleet = m_fleet & ~m_shipCells[shipId];
+    m_shipCells[shipId] = Bitboard();
     if (dir == VERTICAL)
         for (int r = topOrLeft.r; r < topOrLeft.r + m_game.shipLength(shipId) ; r++)
             m_grid[r][topOrLeft.c] = '.';
@@ -192,6 +213,9 @@ bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
     
     
     
+    int cell = cellIndex(p);
+    m_shot.set(cell);
+    
     // If the ocean was hit, attack missed
     if (m_grid[p.r][p.c] == '.')
     {
@@ -202,36 +226,110 @@ bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
     else
     {
         shotHit = true;
-        char ship_symbol;
-        ship_symbol = m_grid[p.r][p.c];
         m_grid[p.r][p.c] = 'X';
-        //Search entire grid, if one of the cells have the same symbol, entire ship not destroyed, return true
-        for (int r = 0; r < m_game.rows(); r ++)
-            for (int c = 0; c < m_game.cols(); c++)
-                if (m_grid[r][c] == ship_symbol)
-                    return true;
-    
-        // The ship must have been destroyed
-        shipDestroyed = true;
-        //Find the shipID by checking symbol of each ID from 0 until a match is found.
-        for (int i = 0; i < m_game.nShips(); i++)
-            if (m_game.shipSymbol(i) == ship_symbol)
+        //Find the ship that was hit; it's destroyed once every one of its cells has been shot
+        for (int i = 0; i < int(m_shipCells.size()); i++)
+            if (m_shipCells[i].test(cell))
             {
-                shipId = i;
+                if (m_shot.contains(m_shipCells[i]))
+                {
+                    shipDestroyed = true;
+                    shipId = i;
+                }
                 break;
             }
         return true;
     }
 }
 
+int BoardImpl::attackBatch(const Point* points, int n, SalvoResult& result)
+{
+    result.clear();
+    if (n > MAXSALVO)
+        n = MAXSALVO;
+    //Mark every valid shot of the salvo first; a repeat within it is wasted like any other
+    Bitboard salvo;
+    for (int i = 0; i < n; i++)
+    {
+        Point p = points[i];
+        if (!m_game.isValid(p))
+            continue;
+        int cell = cellIndex(p);
+        if (m_shot.test(cell)  ||  salvo.test(cell))
+            continue;
+        salvo.set(cell);
+        result.valid |= uint64_t(1) << i;
+        if (m_fleet.test(cell))
+        {
+            result.hit |= uint64_t(1) << i;
+            m_grid[p.r][p.c] = 'X';
+        }
+        else
+            m_grid[p.r][p.c] = 'o';
+    }
+    m_shot |= salvo;
+
+    //Each ship the salvo finished off is credited to the last of its shots that hit it
+    Bitboard hits = salvo & m_fleet;
+    for (int s = 0; s < int(m_shipCells.size())  &&  hits.any(); s++)
+    {
+        if (!m_shipCells[s].intersects(hits)  ||  !m_shot.contains(m_shipCells[s]))
+            continue;
+        for (int i = n - 1; i >= 0; i--)
+            if ((result.hit >> i & 1)  &&  m_shipCells[s].test(cellIndex(points[i])))
+            {
+                result.sunk |= uint64_t(1) << i;
+                result.shipId[i] = s;
+                break;
+            }
+        hits = hits & ~m_shipCells[s];
+    }
+    return n;
+}
+
 bool BoardImpl::allShipsDestroyed() const
 {
-    //Check every cell of grid, return false if a ship symbol was found
-    for (int r = 0; r < m_game.rows(); r ++)
+    //Every cell holding a ship has been shot
+    return m_shot.contains(m_fleet);
+}
+
+int BoardImpl::shipsAfloat() const
+{
+    int n = 0;
+    for (int s = 0; s < int(m_shipCells.size()); s++)
+        if (isPlaced(s)  &&  !m_shot.contains(m_shipCells[s]))
+            n++;
+    return n;
+}
+
+bool BoardImpl::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    if (shipId < 0 || shipId >= m_game.nShips() || !isPlaced(shipId))
+        return false;
+    topOrLeft = cellPoint(m_placed[shipId] / 2);
+    dir = (m_placed[shipId] % 2 == 1 ? VERTICAL : HORIZONTAL);
+    return true;
+}
+
+bool BoardImpl::snapshot(CompactBoard& out) const
+{
+    if (m_game.nShips() > MAXCOMPACTSHIPS)
+        return false;
+    shared_ptr<const FleetCatalog> fleet = m_game.catalog();
+    out.clear();
+    for (int s = 0; s < m_game.nShips(); s++)
+        if (isPlaced(s))
+        {
+            Point topOrLeft;
+            Direction dir;
+            shipPlacement(s, topOrLeft, dir);
+            if (!out.placeShip(*fleet, topOrLeft, s, dir))
+                return false;
+        }
+    for (int r = 0; r < m_game.rows(); r++)
         for (int c = 0; c < m_game.cols(); c++)
-         if (m_grid[r][c] != 'o' && m_grid[r][c] != 'X' && m_grid[r][c] != '.')
-             return false;
-    //If no ship symbols were found in any cell, all ships must have been destroyed 
+            if (m_grid[r][c] == 'o'  ||  m_grid[r][c] == 'X')
+                out.setShot(Point(r, c));
     return true;
 }
 
@@ -282,10 +380,32 @@ void Board::display(bool shotsOnly) const
 
 bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
+    TRACE_SPAN("attack");
     return m_impl->attack(p, shotHit, shipDestroyed, shipId);
 }
 
+int Board::attackBatch(const Point* points, int n, SalvoResult& result)
+{
+    TRACE_SPAN("attackBatch");
+    return m_impl->attackBatch(points, n, result);
+}
+
 bool Board::allShipsDestroyed() const
 {
     return m_impl->allShipsDestroyed();
 }
+
+int Board::shipsAfloat() const
+{
+    return m_impl->shipsAfloat();
+}
+
+bool Board::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    return m_impl->shipPlacement(shipId, topOrLeft, dir);
+}
+
+bool Board::snapshot(CompactBoard& out) const
+{
+    return m_impl->snapshot(out);
+}
@@ -2,9 +2,28 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <cstdint>
 
 class Game;
 class BoardImpl;
+class CompactBoard;
+
+  // The most shots one salvo can hold
+const int MAXSALVO = 64;
+
+  // What each shot of a salvo did.  Bit i of each mask is about the i-th
+  // point of the salvo.
+struct SalvoResult
+{
+    std::uint64_t valid;
+    std::uint64_t hit;
+    std::uint64_t sunk;               // the shot destroyed a ship...
+    int shipId[MAXSALVO];             // ...and this was its ship id
+    void clear() { valid = hit = sunk = 0; }
+    bool isValid(int i) const { return (valid >> i & 1) != 0; }
+    bool isHit(int i) const { return (hit >> i & 1) != 0; }
+    bool isSunk(int i) const { return (sunk >> i & 1) != 0; }
+};
 
 class Board
 {
@@ -18,7 +37,18 @@ class Board
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+      // Resolve a salvo of n shots (at most MAXSALVO) at once, as if each
+      // were attacked in order.  Returns the number of shots resolved.
+    int attackBatch(const Point* points, int n, SalvoResult& result);
     bool allShipsDestroyed() const;
+      // How many placed ships still have a cell that hasn't been hit
+    int shipsAfloat() const;
+      // Where ship shipId was placed; false if it isn't on the board
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+      // Copy the ships and shots so far into a CompactBoard using the
+      // game's catalog; false if the board has more ships than a
+      // CompactBoard can hold
+    bool snapshot(CompactBoard& out) const;
       // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
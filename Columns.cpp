@@ -0,0 +1,230 @@
+#include "Columns.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    const unsigned char VERSION = 1;
+    const size_t FIXEDHEADERSIZE = 22;   // up to and including the column count
+    const size_t NGAMESOFFSET = 12;
+
+    void putLittleEndian(unsigned char* p, uint64_t value, int nBytes)
+    {
+        for (int i = 0; i < nBytes; i++)
+            p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    uint64_t getLittleEndian(const unsigned char* p, int nBytes)
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < nBytes; i++)
+            value |= uint64_t(p[i]) << (8 * i);
+        return value;
+    }
+
+    //Every column, in the order they're stored
+    void columnLayout(int nShips, vector<string>& names, vector<int>& widths)
+    {
+        const char* fixed[] = { "index", "seed", "winner", "seatOfA", "outcome",
+                                "shots0", "shots1", "hits0", "hits1", "wasted0", "wasted1" };
+        const int fixedWidths[] = { 8, 8, 1, 1, 1, 2, 2, 2, 2, 2, 2 };
+        names.assign(fixed, fixed + 11);
+        widths.assign(fixedWidths, fixedWidths + 11);
+        for (int seat = 0; seat < 2; seat++)
+            for (int s = 0; s < nShips; s++)
+            {
+                names.push_back("sink" + to_string(seat) + "." + to_string(s));
+                widths.push_back(2);
+            }
+    }
+
+    //Each column's values lie together, one after another, within a block
+    size_t columnOffsets(const vector<int>& widths, int gamesPerBlock, vector<size_t>& offsets)
+    {
+        offsets.clear();
+        size_t offset = 0;
+        for (size_t c = 0; c < widths.size(); c++)
+        {
+            offsets.push_back(offset);
+            offset += size_t(widths[c]) * gamesPerBlock;
+        }
+        return offset;
+    }
+}
+
+//******************** ColumnWriter ********************************
+
+ColumnWriter::ColumnWriter()
+ : m_nShips(0), m_gamesPerBlock(0), m_inBlock(0), m_nGames(0)
+{}
+
+ColumnWriter::~ColumnWriter()
+{
+    close();
+}
+
+bool ColumnWriter::open(const string& path, int nShips, int gamesPerBlock)
+{
+    close();
+    if (nShips < 0  ||  nShips > MAXSHIPS  ||  gamesPerBlock < 1)
+        return false;
+    m_out.open(path.c_str(), ios::binary | ios::trunc);
+    if (!m_out)
+        return false;
+    m_nShips = nShips;
+    m_gamesPerBlock = gamesPerBlock;
+    m_inBlock = 0;
+    m_nGames = 0;
+
+    vector<string> names;
+    columnLayout(nShips, names, m_widths);
+    m_block.assign(columnOffsets(m_widths, gamesPerBlock, m_offsets), 0);
+
+    //The game count is filled in by close
+    vector<unsigned char> header(FIXEDHEADERSIZE, 0);
+    memcpy(&header[0], "BSCL", 4);
+    header[4] = VERSION;
+    header[5] = static_cast<unsigned char>(nShips);
+    putLittleEndian(&header[8], gamesPerBlock, 4);
+    putLittleEndian(&header[20], names.size(), 2);
+    for (size_t c = 0; c < names.size(); c++)
+    {
+        header.push_back(static_cast<unsigned char>(m_widths[c]));
+        header.push_back(static_cast<unsigned char>(names[c].size()));
+        header.insert(header.end(), names[c].begin(), names[c].end());
+    }
+    header.resize((header.size() + 63) / 64 * 64, 0);
+    m_out.write(reinterpret_cast<const char*>(&header[0]), header.size());
+    return bool(m_out);
+}
+
+void ColumnWriter::add(long long gameIndex, unsigned long long seed, int seatOfA,
+                       const GameRecord& record)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_out.is_open())
+        return;
+    int64_t values[11 + 2 * MAXSHIPS] = {
+        gameIndex, int64_t(seed), record.winner, seatOfA, record.outcome,
+        record.shots[0], record.shots[1], record.hits[0], record.hits[1],
+        record.wasted[0], record.wasted[1]
+    };
+    int n = 11;
+    for (int seat = 0; seat < 2; seat++)
+        for (int s = 0; s < m_nShips; s++)
+            values[n++] = record.sinkTurn[seat][s];
+    for (int c = 0; c < n; c++)
+        putLittleEndian(&m_block[m_offsets[c] + size_t(m_widths[c]) * m_inBlock],
+                        uint64_t(values[c]), m_widths[c]);
+    m_nGames++;
+    if (++m_inBlock == m_gamesPerBlock)
+        flushBlock();
+}
+
+void ColumnWriter::flushBlock()
+{
+    m_out.write(reinterpret_cast<const char*>(&m_block[0]), m_block.size());
+    fill(m_block.begin(), m_block.end(), 0);
+    m_inBlock = 0;
+}
+
+bool ColumnWriter::close()
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_out.is_open())
+        return true;
+    if (m_inBlock > 0)
+        flushBlock();
+    unsigned char count[8];
+    putLittleEndian(count, uint64_t(m_nGames), 8);
+    m_out.seekp(NGAMESOFFSET);
+    m_out.write(reinterpret_cast<const char*>(count), 8);
+    bool ok = bool(m_out);
+    m_out.close();
+    return ok;
+}
+
+//******************** ColumnReader ********************************
+
+ColumnReader::ColumnReader()
+ : m_nShips(0), m_gamesPerBlock(0), m_nGames(0), m_blockBytes(0), m_dataStart(0)
+{}
+
+bool ColumnReader::open(const string& path)
+{
+    m_nGames = 0;
+    m_names.clear();
+    m_widths.clear();
+    if (!m_file.open(path))
+        return false;
+    const unsigned char* data = m_file.data();
+    size_t size = m_file.size();
+    if (size < FIXEDHEADERSIZE  ||  memcmp(data, "BSCL", 4) != 0  ||  data[4] != VERSION)
+        return false;
+    m_nShips = data[5];
+    m_gamesPerBlock = int(getLittleEndian(data + 8, 4));
+    long long nGames = (long long)(getLittleEndian(data + NGAMESOFFSET, 8));
+    int nColumns = int(getLittleEndian(data + 20, 2));
+    if (m_gamesPerBlock < 1)
+        return false;
+
+    size_t pos = FIXEDHEADERSIZE;
+    for (int c = 0; c < nColumns; c++)
+    {
+        if (pos + 2 > size  ||  pos + 2 + data[pos + 1] > size)
+            return false;
+        int width = data[pos];
+        if (width < 1  ||  width > 8)
+            return false;
+        m_widths.push_back(width);
+        m_names.push_back(string(reinterpret_cast<const char*>(data + pos + 2), data[pos + 1]));
+        pos += 2 + data[pos + 1];
+    }
+    m_dataStart = (pos + 63) / 64 * 64;
+    m_blockBytes = columnOffsets(m_widths, m_gamesPerBlock, m_offsets);
+
+    //Every block, including the last, is full size
+    long long blocks = (nGames + m_gamesPerBlock - 1) / m_gamesPerBlock;
+    if (m_dataStart + blocks * m_blockBytes > size)
+        return false;
+    m_nGames = nGames;
+    return true;
+}
+
+int ColumnReader::findColumn(const string& name) const
+{
+    for (size_t c = 0; c < m_names.size(); c++)
+        if (m_names[c] == name)
+            return int(c);
+    return -1;
+}
+
+long long ColumnReader::nBlocks() const
+{
+    return (m_nGames + m_gamesPerBlock - 1) / m_gamesPerBlock;
+}
+
+int ColumnReader::gamesInBlock(long long block) const
+{
+    long long left = m_nGames - block * m_gamesPerBlock;
+    return int(left < m_gamesPerBlock ? left : m_gamesPerBlock);
+}
+
+const unsigned char* ColumnReader::columnData(long long block, int col) const
+{
+    return m_file.data() + m_dataStart + size_t(block) * m_blockBytes + m_offsets[col];
+}
+
+long long ColumnReader::value(int col, long long row) const
+{
+    int width = m_widths[col];
+    const unsigned char* p = columnData(row / m_gamesPerBlock, col) +
+                             size_t(width) * (row % m_gamesPerBlock);
+    uint64_t v = getLittleEndian(p, width);
+    //Sign-extend from the column's width
+    if (width < 8  &&  (v >> (8 * width - 1)) & 1)
+        v |= ~uint64_t(0) << (8 * width);
+    return (long long)(v);
+}
@@ -0,0 +1,93 @@
+#ifndef COLUMNS_INCLUDED
+#define COLUMNS_INCLUDED
+
+#include "Game.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+  // A columnar results file holds one row per game: the game's index and
+  // seed, the winning seat, the seat player A sat in, the outcome, each
+  // seat's shots, hits and wasted shots, and the shot on which each seat
+  // sank each opposing ship (-1 if it didn't).  Rows are stored in blocks
+  // of a fixed number of games, and within a block each column's values
+  // are stored together, so a reader that maps the file can scan one
+  // column without touching the others.  All numbers are little-endian
+  // signed integers.
+  //
+  //   header:  "BSCL", version, number of ships, 2 unused bytes, games per
+  //            block (4 bytes), number of games (8), number of columns (2),
+  //            then for each column its width in bytes, name length and
+  //            name; zero bytes pad the header to a multiple of 64
+  //   block:   for each column in order, games-per-block values of its
+  //            width; the last block is padded out to full size
+  //
+  // Rows appear in the order games finish, which in a parallel run isn't
+  // game order; the index column says which game each row is.
+
+class ColumnWriter
+{
+  public:
+    ColumnWriter();
+    ~ColumnWriter();
+    bool open(const std::string& path, int nShips, int gamesPerBlock = 4096);
+      // Add one game's row; safe to call from several threads
+    void add(long long gameIndex, unsigned long long seed, int seatOfA,
+             const GameRecord& record);
+      // Write the last block and the game count; returns false if anything
+      // failed to be written
+    bool close();
+      // We prevent a ColumnWriter object from being copied or assigned
+    ColumnWriter(const ColumnWriter&) = delete;
+    ColumnWriter& operator=(const ColumnWriter&) = delete;
+
+  private:
+    std::ofstream m_out;
+    std::mutex m_mutex;
+    int m_nShips;
+    int m_gamesPerBlock;
+    std::vector<int> m_widths;
+    std::vector<std::size_t> m_offsets;   // of each column within a block
+    std::vector<unsigned char> m_block;
+    int m_inBlock;
+    long long m_nGames;
+    void flushBlock();
+};
+
+class ColumnReader
+{
+  public:
+    ColumnReader();
+    bool open(const std::string& path);
+    int nShips() const { return m_nShips; }
+    long long nGames() const { return m_nGames; }
+    int nColumns() const { return int(m_names.size()); }
+    const std::string& columnName(int col) const { return m_names[col]; }
+    int columnWidth(int col) const { return m_widths[col]; }
+      // The column with this name (e.g. "winner", "shots0", "sink1.2"), or -1
+    int findColumn(const std::string& name) const;
+    long long nBlocks() const;
+    int gamesInBlock(long long block) const;
+      // A block's values of one column, gamesInBlock(block) of them, each
+      // columnWidth(col) bytes
+    const unsigned char* columnData(long long block, int col) const;
+      // One value, sign-extended
+    long long value(int col, long long row) const;
+
+  private:
+    MappedFile m_file;
+    int m_nShips;
+    int m_gamesPerBlock;
+    long long m_nGames;
+    std::vector<std::string> m_names;
+    std::vector<int> m_widths;
+    std::vector<std::size_t> m_offsets;
+    std::size_t m_blockBytes;
+    std::size_t m_dataStart;
+};
+
+#endif // COLUMNS_INCLUDED
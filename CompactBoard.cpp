@@ -0,0 +1,101 @@
+#include "CompactBoard.h"
+#include "Fleet.h"
+#include <algorithm>
+
+using namespace std;
+
+void CompactBoard::clear()
+{
+    m_shot = Bitboard();
+    m_ships = Bitboard();
+    fill(m_placement, m_placement + MAXCOMPACTSHIPS, NOT_PLACED);
+}
+
+bool CompactBoard::placeShip(const FleetCatalog& fleet, Point topOrLeft, int shipId, Direction dir)
+{
+    if (shipId < 0  ||  shipId >= fleet.nShips()  ||  shipId >= MAXCOMPACTSHIPS)
+        return false;
+    if (m_placement[shipId] != NOT_PLACED)
+        return false;
+    //The catalog only holds placements that fit on the board
+    int i = fleet.placementIndex(shipId, topOrLeft, dir);
+    if (i < 0  ||  i >= NOT_PLACED)
+        return false;
+    const Bitboard& mask = fleet.placements(shipId)[i].mask;
+    if (mask.intersects(m_ships))
+        return false;
+    m_ships |= mask;
+    m_placement[shipId] = static_cast<uint8_t>(i);
+    return true;
+}
+
+bool CompactBoard::unplaceShip(const FleetCatalog& fleet, int shipId)
+{
+    if (shipId < 0  ||  shipId >= fleet.nShips()  ||  shipId >= MAXCOMPACTSHIPS)
+        return false;
+    if (m_placement[shipId] == NOT_PLACED)
+        return false;
+    m_ships = m_ships & ~fleet.placements(shipId)[m_placement[shipId]].mask;
+    m_placement[shipId] = NOT_PLACED;
+    return true;
+}
+
+bool CompactBoard::attack(const FleetCatalog& fleet, Point p, bool& shotHit, bool& shipDestroyed,
+                          int& shipId)
+{
+    shotHit = false;
+    shipDestroyed = false;
+    if (p.r < 0  ||  p.r >= fleet.rows()  ||  p.c < 0  ||  p.c >= fleet.cols())
+        return false;
+    int cell = cellIndex(p);
+    if (m_shot.test(cell))
+        return false;
+    m_shot.set(cell);
+    if (!m_ships.test(cell))
+        return true;
+
+    //Find the ship that was hit; it's destroyed once all its cells have been shot
+    shotHit = true;
+    int n = min(fleet.nShips(), MAXCOMPACTSHIPS);
+    for (int s = 0; s < n; s++)
+    {
+        if (m_placement[s] == NOT_PLACED)
+            continue;
+        const Bitboard& mask = fleet.placements(s)[m_placement[s]].mask;
+        if (mask.test(cell))
+        {
+            if (m_shot.contains(mask))
+            {
+                shipDestroyed = true;
+                shipId = s;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+//A valid attack only ever adds its cell to the shots, so removing it restores the board
+bool CompactBoard::undoAttack(Point p)
+{
+    if (p.r < 0  ||  p.r >= MAXROWS  ||  p.c < 0  ||  p.c >= MAXCOLS)
+        return false;
+    int cell = cellIndex(p);
+    if (!m_shot.test(cell))
+        return false;
+    m_shot.reset(cell);
+    return true;
+}
+
+bool CompactBoard::shipPlacement(const FleetCatalog& fleet, int shipId, Point& topOrLeft,
+                                 Direction& dir) const
+{
+    if (shipId < 0  ||  shipId >= fleet.nShips()  ||  shipId >= MAXCOMPACTSHIPS)
+        return false;
+    if (m_placement[shipId] == NOT_PLACED)
+        return false;
+    const Placement& p = fleet.placements(shipId)[m_placement[shipId]];
+    topOrLeft = p.topOrLeft;
+    dir = p.dir;
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef COMPACTBOARD_INCLUDED
+#define COMPACTBOARD_INCLUDED
+
+#include "Bitboard.h"
+#include <cstdint>
+
+class FleetCatalog;
+
+  // The state of one player's board packed into a few dozen bytes, for
+  // keeping very many games in memory at once.  Everything that's the same
+  // in every game -- board size, ship lengths, symbols and names, and where
+  // a ship can go -- lives in a FleetCatalog that the caller passes in and
+  // that any number of boards may share.  A board holds only the cells shot
+  // at, the cells its ships cover, and which catalog placement each ship is
+  // at.  Fleets of up to MAXCOMPACTSHIPS ships are supported, and unlike
+  // Board there is no blocking or display.
+  //
+  // A CompactBoard is a plain value, so copying one is cheap, and every
+  // valid attack can be taken back with undoAttack in constant time;
+  // search players can try hypothetical shots on a snapshot of the real
+  // board (see Board::snapshot) without copying or allocating.
+const int MAXCOMPACTSHIPS = 16;
+
+class CompactBoard
+{
+  public:
+    CompactBoard() { clear(); }
+    void clear();
+    bool placeShip(const FleetCatalog& fleet, Point topOrLeft, int shipId, Direction dir);
+    bool unplaceShip(const FleetCatalog& fleet, int shipId);
+    bool attack(const FleetCatalog& fleet, Point p, bool& shotHit, bool& shipDestroyed,
+                int& shipId);
+      // Take back a valid attack on p; attacks can be taken back in any
+      // order.  Returns false if p hasn't been shot.
+    bool undoAttack(Point p);
+      // Mark p as shot without working out what the shot did
+    void setShot(Point p) { m_shot.set(cellIndex(p)); }
+    bool allShipsDestroyed() const { return m_shot.contains(m_ships); }
+      // Where ship shipId was placed; false if it isn't on the board
+    bool shipPlacement(const FleetCatalog& fleet, int shipId, Point& topOrLeft,
+                       Direction& dir) const;
+    const Bitboard& shots() const { return m_shot; }
+    const Bitboard& ships() const { return m_ships; }
+
+  private:
+    static constexpr std::uint8_t NOT_PLACED = 0xFF;
+    Bitboard m_shot;
+    Bitboard m_ships;
+    std::uint8_t m_placement[MAXCOMPACTSHIPS];  // index into the catalog's placements
+};
+
+#endif // COMPACTBOARD_INCLUDED
@@ -0,0 +1,145 @@
+#include "DensityMap.h"
+#include "Fleet.h"
+#include "globals.h"
+#include <algorithm>
+
+using namespace std;
+
+DensityMap::DensityMap(shared_ptr<const FleetCatalog> fleet)
+ : m_fleet(fleet), m_covering(MAXCELLS)
+{
+    //Number every placement of every ship and index each one under its cells
+    for (int s = 0; s < m_fleet->nShips(); s++)
+    {
+        m_first.push_back(int(m_mask.size()));
+        const vector<Placement>& placements = m_fleet->placements(s);
+        for (size_t i = 0; i < placements.size(); i++)
+        {
+            int id = int(m_mask.size());
+            m_ship.push_back(s);
+            m_mask.push_back(placements[i].mask);
+            for (Bitboard cells = placements[i].mask; cells.any(); )
+                m_covering[cells.popLowest()].push_back(id);
+        }
+    }
+    m_first.push_back(int(m_mask.size()));
+    clear();
+}
+
+void DensityMap::clear()
+{
+    m_live.assign(m_mask.size(), 1);
+    m_hits.assign(m_mask.size(), 0);
+    fill(m_hitCount, m_hitCount + MAXCELLS, 0);
+    for (int cell = 0; cell < MAXCELLS; cell++)
+        m_count[cell] = int(m_covering[cell].size());
+    m_shot = Bitboard();
+    m_openHits = Bitboard();
+}
+
+//Take a placement out of the counts for good
+void DensityMap::kill(int id)
+{
+    if (!m_live[id])
+        return;
+    m_live[id] = 0;
+    for (Bitboard cells = m_mask[id]; cells.any(); )
+    {
+        int cell = cells.popLowest();
+        m_count[cell]--;
+        if (m_hits[id] > 0)
+            m_hitCount[cell]--;
+    }
+}
+
+void DensityMap::record(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (!validShot)
+        return;
+    int cell = cellIndex(p);
+    if (m_shot.test(cell))
+        return;
+    m_shot.set(cell);
+    const vector<int>& covering = m_covering[cell];
+
+    //No ship can lie across a miss
+    if (!shotHit)
+    {
+        for (size_t i = 0; i < covering.size(); i++)
+            kill(covering[i]);
+        return;
+    }
+
+    //A hit makes every live placement through it a candidate for finishing off
+    m_openHits.set(cell);
+    for (size_t i = 0; i < covering.size(); i++)
+    {
+        int id = covering[i];
+        if (!m_live[id])
+            continue;
+        if (m_hits[id]++ == 0)
+            for (Bitboard cells = m_mask[id]; cells.any(); )
+                m_hitCount[cells.popLowest()]++;
+    }
+    if (!shipDestroyed  ||  shipId < 0  ||  shipId >= m_fleet->nShips())
+        return;
+
+    //The destroyed ship lies on hits through this cell; if only one of its
+    //placements fits, its cells are accounted for and nothing else can use them
+    int found = -1;
+    int nFound = 0;
+    for (size_t i = 0; i < covering.size(); i++)
+    {
+        int id = covering[i];
+        if (m_live[id]  &&  m_ship[id] == shipId  &&  m_openHits.contains(m_mask[id]))
+        {
+            found = id;
+            nFound++;
+        }
+    }
+    if (nFound == 1)
+    {
+        Bitboard sunk = m_mask[found];
+        m_openHits = m_openHits & ~sunk;
+        for (Bitboard cells = sunk; cells.any(); )
+        {
+            const vector<int>& through = m_covering[cells.popLowest()];
+            for (size_t i = 0; i < through.size(); i++)
+                kill(through[i]);
+        }
+    }
+    //Either way, the destroyed ship has no other placements
+    for (int id = m_first[shipId]; id < m_first[shipId + 1]; id++)
+        kill(id);
+}
+
+int DensityMap::bestCell(const Bitboard& exclude) const
+{
+    Bitboard unshot = Bitboard::area(m_fleet->rows(), m_fleet->cols()) & ~m_shot & ~exclude;
+    bool targeting = false;
+    for (Bitboard cells = unshot; cells.any(); )
+        if (m_hitCount[cells.popLowest()] > 0)
+        {
+            targeting = true;
+            break;
+        }
+    const int* counts = targeting ? m_hitCount : m_count;
+
+    //Pick uniformly among the cells tied for the highest count
+    int best = -1;
+    int bestCount = -1;
+    int nTied = 0;
+    for (Bitboard cells = unshot; cells.any(); )
+    {
+        int cell = cells.popLowest();
+        if (counts[cell] > bestCount)
+        {
+            best = cell;
+            bestCount = counts[cell];
+            nTied = 1;
+        }
+        else if (counts[cell] == bestCount  &&  randInt(++nTied) == 0)
+            best = cell;
+    }
+    return best;
+}
@@ -0,0 +1,52 @@
+#ifndef DENSITYMAP_INCLUDED
+#define DENSITYMAP_INCLUDED
+
+#include "Bitboard.h"
+#include <vector>
+#include <memory>
+
+class FleetCatalog;
+
+  // For each cell, how many placements of ships not yet destroyed cover it
+  // and are still possible given the shots so far.  Rather than recounting
+  // every placement after every shot, the map keeps an inverted index from
+  // each cell to the placements covering it: a shot touches only the
+  // placements through that cell and adjusts the counts of their cells by
+  // the difference, so the work per shot is proportional to the placements
+  // it affects, not to the size of the board.
+  //
+  // Alongside the plain counts it keeps hit counts, which count only the
+  // live placements covering at least one hit on a ship not yet known to
+  // be destroyed; those are what to shoot at while finishing off a ship.
+class DensityMap
+{
+  public:
+    DensityMap(std::shared_ptr<const FleetCatalog> fleet);
+    void clear();
+    void record(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    int count(int cell) const { return m_count[cell]; }
+    int hitCount(int cell) const { return m_hitCount[cell]; }
+      // The unshot cell with the highest hit count, or if there is none, the
+      // one with the highest count; ties are broken at random.  Returns -1
+      // if every cell has been shot.
+    int bestCell() const { return bestCell(Bitboard()); }
+      // Likewise, but never one of the excluded cells
+    int bestCell(const Bitboard& exclude) const;
+
+  private:
+    std::shared_ptr<const FleetCatalog> m_fleet;
+    std::vector<int> m_first;               // first placement id of each ship
+    std::vector<int> m_ship;                // ship of each placement id
+    std::vector<Bitboard> m_mask;           // cells of each placement id
+    std::vector<std::vector<int> > m_covering;  // per cell, placement ids covering it
+    std::vector<char> m_live;
+    std::vector<unsigned char> m_hits;      // open hits covered, per placement id
+    int m_count[MAXCELLS];
+    int m_hitCount[MAXCELLS];
+    Bitboard m_shot;
+    Bitboard m_openHits;                    // hits not yet attributed to a sunk ship
+
+    void kill(int id);
+};
+
+#endif // DENSITYMAP_INCLUDED
@@ -0,0 +1,337 @@
+#include "Differential.h"
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "Fleet.h"
+#include "CompactBoard.h"
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+    class CompactBackend : public BoardBackend
+    {
+      public:
+        CompactBackend(shared_ptr<const FleetCatalog> fleet) : m_fleet(fleet) {}
+        virtual void clear() { m_board.clear(); }
+        virtual bool placeShip(Point topOrLeft, int shipId, Direction dir)
+        {
+            return m_board.placeShip(*m_fleet, topOrLeft, shipId, dir);
+        }
+        virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+        {
+            return m_board.attack(*m_fleet, p, shotHit, shipDestroyed, shipId);
+        }
+        virtual bool allShipsDestroyed() const { return m_board.allShipsDestroyed(); }
+
+      private:
+        shared_ptr<const FleetCatalog> m_fleet;
+        CompactBoard m_board;
+    };
+
+    string describeShot(Point p)
+    {
+        return "(" + to_string(p.r) + "," + to_string(p.c) + ")";
+    }
+
+    //Fire one shot at both boards; false, saying how, if they disagree
+    bool compareShot(Board& reference, BoardBackend& backend, Point p, string& what)
+    {
+        bool hit = false, destroyed = false;
+        int id = -1;
+        bool valid = reference.attack(p, hit, destroyed, id);
+        bool hit2 = false, destroyed2 = false;
+        int id2 = -1;
+        bool valid2 = backend.attack(p, hit2, destroyed2, id2);
+        //The ship id only means something when a ship was destroyed
+        if (valid != valid2  ||  hit != hit2  ||  destroyed != destroyed2  ||
+                                                    (destroyed  &&  id != id2))
+        {
+            what = "shot at " + describeShot(p) + ": reference says valid " + to_string(valid) +
+                   " hit " + to_string(hit) + " destroyed " + to_string(destroyed) +
+                   " ship " + to_string(destroyed ? id : -1) + ", backend says valid " +
+                   to_string(valid2) + " hit " + to_string(hit2) + " destroyed " +
+                   to_string(destroyed2) + " ship " + to_string(destroyed2 ? id2 : -1);
+            return false;
+        }
+        if (reference.allShipsDestroyed() != backend.allShipsDestroyed())
+        {
+            what = "after the shot at " + describeShot(p) + ", reference says all ships " +
+                   (reference.allShipsDestroyed() ? "are" : "are not") + " destroyed";
+            return false;
+        }
+        return true;
+    }
+
+    //Fire shots at the layout on fresh boards; the index of the first shot
+    //they disagree on, or -1 if none
+    int firstDisagreement(const DifferentialOptions& options, shared_ptr<const FleetCatalog> fleet,
+                          const Divergence& d, const vector<Point>& shots, string& what)
+    {
+        Game g(fleet);
+        Board reference(g);
+        BoardBackend* backend = options.makeBackend(fleet);
+        backend->clear();
+        int result = -1;
+        for (int s = 0; s < g.nShips(); s++)
+            if (!reference.placeShip(d.layout[s], s, d.directions[s])  ||
+                !backend->placeShip(d.layout[s], s, d.directions[s]))
+            {
+                what = "ship " + to_string(s) + " could not be placed";
+                result = 0;
+                break;
+            }
+        for (size_t i = 0; result < 0  &&  i < shots.size(); i++)
+            if (!compareShot(reference, *backend, shots[i], what))
+                result = int(i);
+        delete backend;
+        return result;
+    }
+
+    //Drop every shot the disagreement doesn't need, one at a time, keeping
+    //each drop after which the boards still disagree
+    void minimize(const DifferentialOptions& options, shared_ptr<const FleetCatalog> fleet,
+                  Divergence& d)
+    {
+        size_t i = 0;
+        while (d.shots.size() > 1  &&  i + 1 < d.shots.size())
+        {
+            vector<Point> fewer(d.shots);
+            fewer.erase(fewer.begin() + i);
+            string what;
+            int k = firstDisagreement(options, fleet, d, fewer, what);
+            if (k >= 0)
+            {
+                fewer.resize(k + 1);
+                d.shots = fewer;
+                d.what = what;
+            }
+            else
+                i++;
+        }
+        string what;
+        if (firstDisagreement(options, fleet, d, d.shots, what) >= 0)
+            d.what = what;
+    }
+
+    //Watches a reference game and mirrors it onto backend boards
+    class MirrorObserver : public GameObserver
+    {
+      public:
+        MirrorObserver(const DifferentialOptions& options, shared_ptr<const FleetCatalog> fleet)
+         : m_fleet(fleet), m_shotsChecked(0), m_diverged(false)
+        {
+            for (int seat = 0; seat < 2; seat++)
+            {
+                m_backends[seat] = options.makeBackend(fleet);
+                m_boards[seat] = nullptr;
+            }
+        }
+        ~MirrorObserver()
+        {
+            delete m_backends[0];
+            delete m_backends[1];
+        }
+        virtual void shipsPlaced(const Board& b1, const Board& b2)
+        {
+            m_boards[0] = &b1;
+            m_boards[1] = &b2;
+            for (int seat = 0; seat < 2; seat++)
+            {
+                m_backends[seat]->clear();
+                m_layouts[seat].clear();
+                m_directions[seat].clear();
+                m_shots[seat].clear();
+                for (int s = 0; s < m_fleet->nShips(); s++)
+                {
+                    Point topOrLeft;
+                    Direction dir = HORIZONTAL;
+                    m_boards[seat]->shipPlacement(s, topOrLeft, dir);
+                    m_layouts[seat].push_back(topOrLeft);
+                    m_directions[seat].push_back(dir);
+                    if (!m_diverged  &&  !m_backends[seat]->placeShip(topOrLeft, s, dir))
+                        diverge(seat, "ship " + to_string(s) + " could not be placed");
+                }
+            }
+        }
+        virtual void shotFired(int seat, Point p, bool validShot, bool shotHit,
+                               bool shipDestroyed, int shipId)
+        {
+            int target = 1 - seat;
+            m_shots[target].push_back(p);
+            if (m_diverged)
+                return;
+            m_shotsChecked++;
+            bool hit2 = false, destroyed2 = false;
+            int id2 = -1;
+            bool valid2 = m_backends[target]->attack(p, hit2, destroyed2, id2);
+            if (validShot != valid2  ||  shotHit != hit2  ||  shipDestroyed != destroyed2  ||
+                                                (shipDestroyed  &&  shipId != id2))
+                diverge(target, "shot at " + describeShot(p) + " disagrees");
+            else if (m_boards[target]->allShipsDestroyed() != m_backends[target]->allShipsDestroyed())
+                diverge(target, "after the shot at " + describeShot(p) +
+                                ", the boards disagree on whether all ships are destroyed");
+        }
+        long long shotsChecked() const { return m_shotsChecked; }
+        bool diverged() const { return m_diverged; }
+        const Divergence& divergence() const { return m_divergence; }
+
+      private:
+        shared_ptr<const FleetCatalog> m_fleet;
+        BoardBackend* m_backends[2];
+        const Board* m_boards[2];
+        vector<Point> m_layouts[2];
+        vector<Direction> m_directions[2];
+        vector<Point> m_shots[2];
+        long long m_shotsChecked;
+        bool m_diverged;
+        Divergence m_divergence;
+
+        void diverge(int seat, const string& what)
+        {
+            m_diverged = true;
+            m_divergence.what = what;
+            m_divergence.seat = seat;
+            m_divergence.layout = m_layouts[seat];
+            m_divergence.directions = m_directions[seat];
+            m_divergence.shots = m_shots[seat];
+        }
+    };
+
+    string describeRecord(const GameRecord& r)
+    {
+        string s = "winner " + to_string(r.winner) + " outcome " + to_string(r.outcome);
+        for (int seat = 0; seat < 2; seat++)
+            s += ", seat " + to_string(seat) + ": " + to_string(r.shots[seat]) + " shots " +
+                 to_string(r.hits[seat]) + " hits " + to_string(r.wasted[seat]) + " wasted";
+        return s;
+    }
+
+    bool sameRecord(const GameRecord& a, const GameRecord& b)
+    {
+        if (a.winner != b.winner  ||  a.outcome != b.outcome)
+            return false;
+        for (int seat = 0; seat < 2; seat++)
+        {
+            if (a.shots[seat] != b.shots[seat]  ||  a.hits[seat] != b.hits[seat]  ||
+                                                    a.wasted[seat] != b.wasted[seat])
+                return false;
+            for (int s = 0; s < MAXSHIPS; s++)
+                if (a.sinkTurn[seat][s] != b.sinkTurn[seat][s])
+                    return false;
+        }
+        return true;
+    }
+
+    struct Checked
+    {
+        long long shots;
+        bool diverged;
+        Divergence divergence;
+    };
+
+    Checked checkGame(const DifferentialOptions& options, shared_ptr<const FleetCatalog> fleet,
+                      long long gameIndex)
+    {
+        const MatchOptions& match = options.match;
+        Checked result;
+        result.diverged = false;
+        int seatOfA = int(gameIndex % 2);
+        unsigned long long seed = gameSeed(match.seed, gameIndex);
+
+        //The reference: Board and the players through the virtual game loop
+        seedRandom(seed);
+        Game g(fleet);
+        g.setLimits(match.limits);
+        MirrorObserver mirror(options, fleet);
+        g.setObserver(&mirror);
+        Player* a = createPlayer(match.typeA, match.typeA, g);
+        Player* b = createPlayer(match.typeB, match.typeB, g);
+        GameRecord reference;
+        if (a != nullptr  &&  b != nullptr)
+        {
+            Player* p1 = (seatOfA == 0 ? a : b);
+            Player* p2 = (seatOfA == 0 ? b : a);
+            if (match.salvo)
+                g.playSalvo(p1, p2, match.salvoShots, &reference);
+            else
+                g.playQuietly(p1, p2, &reference);
+        }
+        delete a;
+        delete b;
+        g.setObserver(nullptr);
+        result.shots = mirror.shotsChecked();
+        if (mirror.diverged())
+        {
+            result.diverged = true;
+            result.divergence = mirror.divergence();
+            minimize(options, fleet, result.divergence);
+        }
+        //The same game through the devirtualized loop must end the same way
+        else if (options.checkFastPlay  &&  !match.salvo)
+        {
+            const string& first = (seatOfA == 0 ? match.typeA : match.typeB);
+            const string& second = (seatOfA == 0 ? match.typeB : match.typeA);
+            seedRandom(seed);
+            GameRecord fast;
+            if (playKnownPairing(first, second, g, fast)  &&  !sameRecord(reference, fast))
+            {
+                result.diverged = true;
+                result.divergence.seat = -1;
+                result.divergence.what = "devirtualized loop ended with " + describeRecord(fast) +
+                                         " but the reference ended with " +
+                                         describeRecord(reference);
+            }
+        }
+        result.divergence.gameIndex = gameIndex;
+        result.divergence.seed = seed;
+        return result;
+    }
+}
+
+BoardBackend* createCompactBackend(shared_ptr<const FleetCatalog> fleet)
+{
+    return new CompactBackend(fleet);
+}
+
+DifferentialResult runDifferential(const DifferentialOptions& options)
+{
+    DifferentialResult result;
+    result.gamesChecked = 0;
+    result.shotsChecked = 0;
+    result.diverged = false;
+    shared_ptr<const FleetCatalog> fleet = matchFleet(options.match);
+    if (fleet == nullptr  ||  fleet->nShips() == 0)
+        return result;
+
+    parallelInOrder<Checked>(options.match.nGames, options.match.nThreads,
+        [&](long long k) {
+            return checkGame(options, fleet, k);
+        },
+        [&](long long, const Checked& checked) {
+            result.gamesChecked++;
+            result.shotsChecked += checked.shots;
+            if (!checked.diverged)
+                return true;
+            result.diverged = true;
+            result.first = checked.divergence;
+            return false;
+        });
+    return result;
+}
+
+void printDivergence(ostream& out, const Divergence& d)
+{
+    out << "Game " << d.gameIndex << " (seed " << d.seed << ") diverged: " << d.what << endl;
+    if (d.seat < 0)
+        return;
+    out << "Minimal replay on seat " << d.seat << "'s board:" << endl;
+    out << "  layout:";
+    for (size_t s = 0; s < d.layout.size(); s++)
+        out << " " << describeShot(d.layout[s]) << (d.directions[s] == VERTICAL ? "v" : "h");
+    out << endl << "  shots:";
+    for (size_t i = 0; i < d.shots.size(); i++)
+        out << " " << describeShot(d.shots[i]);
+    out << endl;
+}
@@ -0,0 +1,74 @@
+#ifndef DIFFERENTIAL_INCLUDED
+#define DIFFERENTIAL_INCLUDED
+
+#include "Tournament.h"
+#include "globals.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+  // A board implementation to be checked against Board, the reference.
+  // Ships are placed and shots fired on it exactly as they are on the
+  // reference board, and it must report exactly the same results.
+class BoardBackend
+{
+  public:
+    virtual ~BoardBackend() {}
+    virtual void clear() = 0;
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) = 0;
+    virtual bool allShipsDestroyed() const = 0;
+};
+
+  // The CompactBoard backend, the one the default options check
+BoardBackend* createCompactBackend(std::shared_ptr<const FleetCatalog> fleet);
+
+struct DifferentialOptions
+{
+      // The games to check, played between match.typeA and match.typeB
+      // with the match's seeds, fleet and threads
+    MatchOptions match;
+    std::function<BoardBackend*(std::shared_ptr<const FleetCatalog>)> makeBackend =
+                                                                    createCompactBackend;
+      // Also play each game through playKnownPairing's devirtualized loop,
+      // when the pairing has one, and check it ends with the same record
+    bool checkFastPlay = true;
+};
+
+  // Where a backend first disagreed with the reference
+struct Divergence
+{
+    long long gameIndex;
+    unsigned long long seed;
+    std::string what;
+      // For a board disagreement, a minimal replay: the fleet layout of the
+      // board that was shot, as (top or left cell, direction) per ship,
+      // and the fewest shots from the game that, fired in order at that
+      // layout, still make the backend disagree on the last of them
+    int seat;                           // whose board it was, -1 if not a board disagreement
+    std::vector<Point> layout;
+    std::vector<Direction> directions;
+    std::vector<Point> shots;
+};
+
+struct DifferentialResult
+{
+    long long gamesChecked;
+    long long shotsChecked;
+    bool diverged;
+    Divergence first;                   // the lowest-numbered game that diverged
+};
+
+  // Play the match games with the reference Board and player logic,
+  // mirroring every placement and shot onto a backend board and comparing
+  // each shot's validity, hit, sinking and ship id and whether the fleet is
+  // destroyed.  Games run in parallel; checking stops after the first game
+  // that diverges, and games are reported in order, so the divergence
+  // found is the same whatever the number of threads.
+DifferentialResult runDifferential(const DifferentialOptions& options);
+
+void printDivergence(std::ostream& out, const Divergence& d);
+
+#endif // DIFFERENTIAL_INCLUDED
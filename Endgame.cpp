@@ -0,0 +1,157 @@
+#include "Endgame.h"
+#include <algorithm>
+
+using namespace std;
+
+EndgameEnumerator::EndgameEnumerator(shared_ptr<const FleetCatalog> fleet)
+ : m_fleet(fleet), m_candidates(fleet->nShips()), m_used(fleet->nShips()),
+   m_maxLayouts(0), m_nLayouts(0), m_nodes(0), m_abandoned(false)
+{
+    //Room for every placement up front, so no shot has to allocate
+    m_order.reserve(fleet->nShips());
+    m_reachable.reserve(fleet->nShips() + 1);
+    for (int s = 0; s < fleet->nShips(); s++)
+    {
+        m_candidates[s].reserve(fleet->placements(s).size());
+        m_used[s].reserve(fleet->placements(s).size());
+    }
+}
+
+//Keep, for each ship, only the placements that agree with what k records about it
+void EndgameEnumerator::findCandidates(const Knowledge& k)
+{
+    Bitboard missed = k.shot & ~k.hit;
+    int nShips = m_fleet->nShips();
+    m_order.clear();
+    for (int s = 0; s < nShips; s++)
+    {
+        m_candidates[s].clear();
+        const vector<Placement>& placements = m_fleet->placements(s);
+        bool sunk = s < int(k.sunkAt.size())  &&  k.sunkAt[s] >= 0;
+        for (size_t i = 0; i < placements.size(); i++)
+        {
+            const Bitboard& mask = placements[i].mask;
+            if (mask.intersects(missed))
+                continue;
+            if (sunk ? !k.hit.contains(mask)  ||  !mask.test(k.sunkAt[s])
+                     : k.hit.contains(mask))
+                continue;
+            m_candidates[s].push_back(int(i));
+        }
+        m_order.push_back(s);
+    }
+    //Ships with few choices first, so dead ends are found near the root.  An
+    //insertion sort is stable like stable_sort but needs no temporary buffer,
+    //and there are only a few ships.
+    for (int i = 1; i < nShips; i++)
+    {
+        int s = m_order[i];
+        int j = i;
+        for ( ; j > 0  &&  m_candidates[m_order[j - 1]].size() > m_candidates[s].size(); j--)
+            m_order[j] = m_order[j - 1];
+        m_order[j] = s;
+    }
+    m_reachable.assign(nShips + 1, Bitboard());
+    for (int d = nShips - 1; d >= 0; d--)
+    {
+        int s = m_order[d];
+        Bitboard cells;
+        for (size_t i = 0; i < m_candidates[s].size(); i++)
+            cells |= m_fleet->placements(s)[m_candidates[s][i]].mask;
+        m_reachable[d] = m_reachable[d + 1] | cells;
+    }
+}
+
+double EndgameEnumerator::estimateLayouts(const Knowledge& k)
+{
+    findCandidates(k);
+    double estimate = 1;
+    for (int s = 0; s < m_fleet->nShips(); s++)
+        estimate *= double(m_candidates[s].size());
+    return estimate;
+}
+
+bool EndgameEnumerator::enumerate(const Knowledge& k, long long maxLayouts,
+                                  Clock::time_point deadline, long long& nLayouts,
+                                  long long* occupancy)
+{
+    findCandidates(k);
+    for (int s = 0; s < m_fleet->nShips(); s++)
+        m_used[s].assign(m_candidates[s].size(), 0);
+    m_hit = k.hit;
+    m_maxLayouts = maxLayouts;
+    m_deadline = deadline;
+    m_nLayouts = 0;
+    m_nodes = 0;
+    m_abandoned = false;
+    search(0, Bitboard());
+    nLayouts = m_nLayouts;
+    if (m_abandoned)
+        return false;
+
+    //Each layout counted per placement turns into a count per cell
+    fill(occupancy, occupancy + MAXCELLS, 0);
+    for (int s = 0; s < m_fleet->nShips(); s++)
+        for (size_t i = 0; i < m_candidates[s].size(); i++)
+            if (m_used[s][i] > 0)
+                for (Bitboard cells = m_fleet->placements(s)[m_candidates[s][i]].mask;
+                                                                            cells.any(); )
+                    occupancy[cells.popLowest()] += m_used[s][i];
+    return true;
+}
+
+//Place ships m_order[depth] onwards; false if no layout could be completed
+bool EndgameEnumerator::search(size_t depth, Bitboard occupied)
+{
+    if (depth == m_order.size())
+    {
+        //Every hit must have landed on some ship
+        if (!occupied.contains(m_hit))
+            return false;
+        if (++m_nLayouts > m_maxLayouts)
+            m_abandoned = true;
+        return true;
+    }
+    if ((++m_nodes & 1023) == 0  &&  Clock::now() > m_deadline)
+        m_abandoned = true;
+    if (m_abandoned)
+        return false;
+    //Hits not yet covered must be reachable by the ships still to place
+    if (!(occupied | m_reachable[depth]).contains(m_hit))
+        return false;
+
+    int s = m_order[depth];
+    const vector<Placement>& placements = m_fleet->placements(s);
+    bool any = false;
+    for (size_t i = 0; i < m_candidates[s].size()  &&  !m_abandoned; i++)
+    {
+        const Bitboard& mask = placements[m_candidates[s][i]].mask;
+        if (mask.intersects(occupied))
+            continue;
+        long long before = m_nLayouts;
+        if (search(depth + 1, occupied | mask))
+        {
+            m_used[s][i] += m_nLayouts - before;
+            any = true;
+        }
+    }
+    return any;
+}
+
+int EndgameEnumerator::bestShot(const Knowledge& k, long long maxLayouts,
+                                Clock::time_point deadline)
+{
+    long long nLayouts;
+    long long occupancy[MAXCELLS];
+    if (!enumerate(k, maxLayouts, deadline, nLayouts, occupancy)  ||  nLayouts == 0)
+        return -1;
+    int best = -1;
+    Bitboard unshot = Bitboard::area(m_fleet->rows(), m_fleet->cols()) & ~k.shot;
+    for (Bitboard cells = unshot; cells.any(); )
+    {
+        int cell = cells.popLowest();
+        if (best < 0  ||  occupancy[cell] > occupancy[best])
+            best = cell;
+    }
+    return best;
+}
@@ -0,0 +1,50 @@
+#ifndef ENDGAME_INCLUDED
+#define ENDGAME_INCLUDED
+
+#include "Fleet.h"
+#include <vector>
+#include <memory>
+#include <chrono>
+
+  // Exact targeting for the end of a game.  Given what a player knows, it
+  // backtracks through every fleet layout that could have produced those
+  // results, counting for each unshot cell how many of them put a ship
+  // there, and picks the cell most likely to hit.  That's only affordable
+  // once few layouts remain, so callers first check estimateLayouts, and
+  // every enumeration gives up past a layout limit or a deadline.
+class EndgameEnumerator
+{
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    EndgameEnumerator(std::shared_ptr<const FleetCatalog> fleet);
+      // An upper bound on the layouts consistent with k: the product over
+      // ships of the placements each could still be at
+    double estimateLayouts(const Knowledge& k);
+      // Count the layouts consistent with k and, for each cell, how many of
+      // them cover it.  Returns false if there are more than maxLayouts or
+      // the deadline passes first.
+    bool enumerate(const Knowledge& k, long long maxLayouts, Clock::time_point deadline,
+                   long long& nLayouts, long long* occupancy);
+      // The unshot cell most likely to hold a ship, or -1 if enumeration
+      // gave up or no layout fits
+    int bestShot(const Knowledge& k, long long maxLayouts, Clock::time_point deadline);
+
+  private:
+    std::shared_ptr<const FleetCatalog> m_fleet;
+    std::vector<int> m_order;                    // ships, fewest candidates first
+    std::vector<std::vector<int> > m_candidates; // per ship, placements fitting k
+    std::vector<Bitboard> m_reachable;           // union of candidates of m_order[d..]
+    std::vector<std::vector<long long> > m_used; // per ship and placement, layouts using it
+    Bitboard m_hit;
+    long long m_maxLayouts;
+    long long m_nLayouts;
+    long long m_nodes;
+    Clock::time_point m_deadline;
+    bool m_abandoned;
+
+    void findCandidates(const Knowledge& k);
+    bool search(std::size_t depth, Bitboard occupied);
+};
+
+#endif // ENDGAME_INCLUDED
@@ -0,0 +1,284 @@
+#include "ExactCover.h"
+#include "Board.h"
+#include "globals.h"
+
+using namespace std;
+
+ExactCoverPlacer::ExactCoverPlacer(shared_ptr<const FleetCatalog> fleet)
+ : m_fleet(fleet)
+{
+    //Ships of the same length have the same placements, so they're interchangeable
+    for (int s = 0; s < m_fleet->nShips(); s++)
+    {
+        size_t g;
+        for (g = 0; g < m_groups.size(); g++)
+            if (m_fleet->shipLength(m_groups[g][0]) == m_fleet->shipLength(s))
+                break;
+        if (g == m_groups.size())
+            m_groups.push_back(vector<int>());
+        m_groups[g].push_back(s);
+        m_group.push_back(int(g));
+    }
+}
+
+int ExactCoverPlacer::addNode(int column)
+{
+    int node = int(m_column.size());
+    m_column.push_back(column);
+    m_left.push_back(node);
+    m_right.push_back(node);
+    //Link in at the bottom of the column
+    m_up.push_back(m_up[column]);
+    m_down.push_back(column);
+    m_down[m_up[column]] = node;
+    m_up[column] = node;
+    m_size[column]++;
+    m_rowShip.push_back(-1);
+    m_rowPlacement.push_back(-1);
+    return node;
+}
+
+//One column per ship, linked from the root, and one per cell, which aren't,
+//since a cell may be left empty; then one row per placement
+void ExactCoverPlacer::build(const Bitboard& forbidden)
+{
+    int nShips = m_fleet->nShips();
+    int nColumns = nShips + MAXCELLS;
+    m_left.assign(nColumns + 1, 0);
+    m_right.assign(nColumns + 1, 0);
+    m_up.resize(nColumns + 1);
+    m_down.resize(nColumns + 1);
+    m_column.resize(nColumns + 1);
+    m_size.assign(nColumns + 1, 0);
+    m_rowShip.assign(nColumns + 1, -1);
+    m_rowPlacement.assign(nColumns + 1, -1);
+    for (int c = 0; c <= nColumns; c++)
+    {
+        m_up[c] = m_down[c] = m_column[c] = c;
+        m_left[c] = m_right[c] = c;
+    }
+    for (int c = 1; c <= nShips; c++)
+    {
+        m_left[c] = c - 1;
+        m_right[c] = (c == nShips ? 0 : c + 1);
+    }
+    m_left[0] = nShips;
+    m_right[0] = (nShips == 0 ? 0 : 1);
+    m_covered.assign(nColumns + 1, 0);
+    m_nPlaced.assign(m_groups.size(), 0);
+    m_lastIndex.assign(m_groups.size(), -1);
+
+    m_cellColumns.clear();
+    m_slack = 0;
+    for (int r = 0; r < m_fleet->rows(); r++)
+        for (int c = 0; c < m_fleet->cols(); c++)
+        {
+            int cell = cellIndex(Point(r, c));
+            if (forbidden.test(cell))
+                continue;
+            m_cellColumns.push_back(1 + nShips + cell);
+            m_slack++;
+        }
+    for (int s = 0; s < nShips; s++)
+        m_slack -= m_fleet->shipLength(s);
+
+    for (int s = 0; s < nShips; s++)
+    {
+        const vector<Placement>& placements = m_fleet->placements(s);
+        for (size_t i = 0; i < placements.size(); i++)
+        {
+            if (placements[i].mask.intersects(forbidden))
+                continue;
+            int first = addNode(1 + s);
+            for (Bitboard cells = placements[i].mask; cells.any(); )
+            {
+                int node = addNode(1 + nShips + cells.popLowest());
+                m_left[node] = m_left[first];
+                m_right[node] = first;
+                m_right[m_left[first]] = node;
+                m_left[first] = node;
+            }
+            //Every node of the row knows which placement it stands for
+            int node = first;
+            do
+            {
+                m_rowShip[node] = s;
+                m_rowPlacement[node] = int(i);
+                node = m_right[node];
+            } while (node != first);
+        }
+    }
+}
+
+void ExactCoverPlacer::cover(int column)
+{
+    m_covered[column] = 1;
+    m_right[m_left[column]] = m_right[column];
+    m_left[m_right[column]] = m_left[column];
+    for (int i = m_down[column]; i != column; i = m_down[i])
+        for (int j = m_right[i]; j != i; j = m_right[j])
+        {
+            m_down[m_up[j]] = m_down[j];
+            m_up[m_down[j]] = m_up[j];
+            m_size[m_column[j]]--;
+        }
+}
+
+void ExactCoverPlacer::uncover(int column)
+{
+    for (int i = m_up[column]; i != column; i = m_up[i])
+        for (int j = m_left[i]; j != i; j = m_left[j])
+        {
+            m_size[m_column[j]]++;
+            m_down[m_up[j]] = j;
+            m_up[m_down[j]] = j;
+        }
+    m_right[m_left[column]] = column;
+    m_left[m_right[column]] = column;
+    m_covered[column] = 0;
+}
+
+//A row may be chosen only if its ship is the next of its group to place,
+//at a later placement than the one before
+bool ExactCoverPlacer::usable(int node) const
+{
+    int g = m_group[m_rowShip[node]];
+    return m_nPlaced[g] < int(m_groups[g].size())  &&
+           m_groups[g][m_nPlaced[g]] == m_rowShip[node]  &&
+           m_rowPlacement[node] > m_lastIndex[g];
+}
+
+int ExactCoverPlacer::usableRows(int column) const
+{
+    int n = 0;
+    for (int i = m_down[column]; i != column; i = m_down[i])
+        if (usable(i))
+            n++;
+    return n;
+}
+
+bool ExactCoverPlacer::search()
+{
+    if (m_right[0] == 0)
+        return true;
+
+    //Give up once more cells are out of every ship's reach than can still be left empty
+    int dead = 0;
+    int firstOpen = -1;
+    for (size_t k = 0; k < m_cellColumns.size(); k++)
+    {
+        int c = m_cellColumns[k];
+        if (m_covered[c])
+            continue;
+        if (firstOpen < 0)
+            firstOpen = c;
+        if (m_size[c] == 0  &&  ++dead > m_slack)
+            return false;
+    }
+
+    //Find the next ship of a group with the fewest placements left, breaking
+    //ties at random
+    int best = -1;
+    int bestSize = 0;
+    int nTied = 0;
+    for (size_t g = 0; g < m_groups.size(); g++)
+    {
+        if (m_nPlaced[g] == int(m_groups[g].size()))
+            continue;
+        int c = 1 + m_groups[g][m_nPlaced[g]];
+        int size = usableRows(c);
+        if (best < 0  ||  size < bestSize)
+        {
+            best = c;
+            bestSize = size;
+            nTied = 1;
+        }
+        else if (size == bestSize  &&  randInt(++nTied) == 0)
+            best = c;
+    }
+    if (bestSize == 0)
+        return false;
+
+    //When it has fewer choices, decide the first open cell instead: some
+    //ship starts there, or (if there's room) it stays empty.  Every cell
+    //before it is decided, so placements are still chosen in index order.
+    bool mayStayEmpty = false;
+    if (firstOpen >= 0)
+    {
+        int size = usableRows(firstOpen) + (m_slack > 0 ? 1 : 0);
+        if (size < bestSize)
+        {
+            best = firstOpen;
+            mayStayEmpty = m_slack > 0;
+        }
+    }
+
+    //Try the choices in random order
+    vector<int> rows;
+    for (int i = m_down[best]; i != best; i = m_down[i])
+        if (usable(i))
+            rows.push_back(i);
+    if (mayStayEmpty)
+        rows.push_back(best);
+    for (size_t k = rows.size(); k > 1; k--)
+        swap(rows[k - 1], rows[randInt(int(k))]);
+
+    cover(best);
+    bool found = false;
+    for (size_t k = 0; k < rows.size()  &&  !found; k++)
+    {
+        int r = rows[k];
+        if (r == best)
+        {
+            //Leave the cell empty
+            m_slack--;
+            found = search();
+            m_slack++;
+            continue;
+        }
+        int g = m_group[m_rowShip[r]];
+        int lastIndex = m_lastIndex[g];
+        m_nPlaced[g]++;
+        m_lastIndex[g] = m_rowPlacement[r];
+        m_chosen.push_back(r);
+        for (int j = m_right[r]; j != r; j = m_right[j])
+            cover(m_column[j]);
+        found = search();
+        for (int j = m_left[r]; j != r; j = m_left[j])
+            uncover(m_column[j]);
+        m_nPlaced[g]--;
+        m_lastIndex[g] = lastIndex;
+        if (!found)
+            m_chosen.pop_back();
+    }
+    uncover(best);
+    return found;
+}
+
+bool ExactCoverPlacer::place(int* placementIds, const Bitboard& forbidden)
+{
+    build(forbidden);
+    m_chosen.clear();
+    if (!search())
+        return false;
+    for (size_t k = 0; k < m_chosen.size(); k++)
+        placementIds[m_rowShip[m_chosen[k]]] = m_rowPlacement[m_chosen[k]];
+    return true;
+}
+
+bool ExactCoverPlacer::placeShips(Board& b, const Bitboard& forbidden)
+{
+    vector<int> ids(m_fleet->nShips());
+    if (!place(ids.data(), forbidden))
+        return false;
+    for (int s = 0; s < m_fleet->nShips(); s++)
+    {
+        const Placement& p = m_fleet->placements(s)[ids[s]];
+        if (!b.placeShip(p.topOrLeft, s, p.dir))
+        {
+            b.clear();
+            return false;
+        }
+    }
+    return true;
+}
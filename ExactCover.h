@@ -0,0 +1,62 @@
+#ifndef EXACTCOVER_INCLUDED
+#define EXACTCOVER_INCLUDED
+
+#include "Fleet.h"
+#include <vector>
+#include <memory>
+
+class Board;
+
+  // Places a fleet by solving an exact cover problem with Knuth's dancing
+  // links (Algorithm X): every ship must be covered exactly once, and
+  // every cell at most once.  Unlike FleetSampler's rejection sampling,
+  // this stays fast however little room the fleet leaves, and when no
+  // layout exists it says so after exhausting the search instead of
+  // running out of attempts.  Ties between equally constrained ships and
+  // the order placements are tried in are random, so layouts vary, though
+  // they aren't all equally likely.
+  //
+  // Three things keep dense fleets from blowing up the search.  Ships of the
+  // same length are interchangeable, so they are placed in id order at
+  // increasing placement indices, and no layout is visited once per
+  // permutation of them.  A branch is abandoned as soon as more cells can
+  // no longer be covered than the fleet leaves empty.  And when the first
+  // undecided cell has fewer choices than any ship, the search branches on
+  // what goes there, which is what tight fleets need.
+class ExactCoverPlacer
+{
+  public:
+    ExactCoverPlacer(std::shared_ptr<const FleetCatalog> fleet);
+      // Fill placementIds (one entry per ship) with a layout that avoids
+      // the forbidden cells; false if there's no such layout
+    bool place(int* placementIds, const Bitboard& forbidden = Bitboard());
+      // Put such a layout on b
+    bool placeShips(Board& b, const Bitboard& forbidden = Bitboard());
+
+  private:
+    std::shared_ptr<const FleetCatalog> m_fleet;
+      // The dancing links: node 0 is the root, then one header per column
+      // (ships first, then cells), then the nodes of the rows
+    std::vector<int> m_left, m_right, m_up, m_down, m_column;
+    std::vector<int> m_size;      // nodes in each column
+    std::vector<int> m_rowShip;   // per node, the ship and placement of its row
+    std::vector<int> m_rowPlacement;
+    std::vector<int> m_chosen;    // a node of each row in the partial solution
+    std::vector<char> m_covered;  // per column
+    std::vector<std::vector<int> > m_groups;  // ships of each length, in id order
+    std::vector<int> m_group;     // per ship, its group
+    std::vector<int> m_nPlaced;   // per group, how many of its ships are placed
+    std::vector<int> m_lastIndex; // per group, the placement of its latest ship
+    std::vector<int> m_cellColumns;  // the columns of cells on the board
+    int m_slack;                  // cells that may still be left empty
+
+    void build(const Bitboard& forbidden);
+    bool usable(int node) const;
+    int usableRows(int column) const;
+    int addNode(int column);
+    void cover(int column);
+    void uncover(int column);
+    bool search();
+};
+
+#endif // EXACTCOVER_INCLUDED
@@ -0,0 +1,292 @@
+#include "Fleet.h"
+#include "Game.h"
+#include "Board.h"
+#include "ExactCover.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+using namespace std;
+
+vector<Placement> shipPlacements(int nRows, int nCols, int length)
+{
+    vector<Placement> result;
+    for (int r = 0; r < nRows; r++)
+        for (int c = 0; c < nCols; c++)
+        {
+            //Horizontal placement with its leftmost cell at (r,c)
+            if (c + length <= nCols)
+            {
+                Bitboard mask;
+                for (int i = 0; i < length; i++)
+                    mask.set(cellIndex(Point(r, c + i)));
+                result.push_back(Placement(Point(r, c), HORIZONTAL, mask));
+            }
+            //Vertical placement with its top cell at (r,c)
+            if (length > 1  &&  r + length <= nRows)
+            {
+                Bitboard mask;
+                for (int i = 0; i < length; i++)
+                    mask.set(cellIndex(Point(r + i, c)));
+                result.push_back(Placement(Point(r, c), VERTICAL, mask));
+            }
+        }
+    return result;
+}
+
+vector<Placement> shipPlacements(const Game& g, int length)
+{
+    return shipPlacements(g.rows(), g.cols(), length);
+}
+
+//******************** FleetCatalog ********************************
+
+FleetCatalog::FleetCatalog(int nRows, int nCols)
+ : m_rows(nRows), m_cols(nCols)
+{}
+
+int FleetCatalog::placementIndex(int shipId, Point topOrLeft, Direction dir) const
+{
+    if (topOrLeft.r < 0  ||  topOrLeft.r >= m_rows  ||  topOrLeft.c < 0  ||  topOrLeft.c >= m_cols)
+        return -1;
+    //A ship of length 1 only has horizontal placements
+    if (m_ships[shipId].length == 1)
+        dir = HORIZONTAL;
+    return m_ships[shipId].index[2 * cellIndex(topOrLeft) + (dir == VERTICAL ? 1 : 0)];
+}
+
+shared_ptr<const FleetCatalog> FleetCatalog::withShip(int length, char symbol,
+                                                      const string& name) const
+{
+    shared_ptr<FleetCatalog> result = make_shared<FleetCatalog>(*this);
+    Ship ship;
+    ship.length = length;
+    ship.symbol = symbol;
+    ship.name = name;
+    ship.placements = shipPlacements(m_rows, m_cols, length);
+    ship.index.assign(2 * MAXCELLS, -1);
+    for (size_t i = 0; i < ship.placements.size(); i++)
+    {
+        const Placement& p = ship.placements[i];
+        ship.index[2 * cellIndex(p.topOrLeft) + (p.dir == VERTICAL ? 1 : 0)] = short(i);
+    }
+    result->m_ships.push_back(ship);
+    return result;
+}
+
+//******************** FleetSampler ********************************
+
+FleetSampler::FleetSampler(const Game& g, int spacing)
+ : m_fleet(g.catalog()), m_spacing(spacing)
+{
+    init();
+}
+
+FleetSampler::FleetSampler(shared_ptr<const FleetCatalog> fleet, int spacing)
+ : m_fleet(fleet), m_spacing(spacing)
+{
+    init();
+}
+
+void FleetSampler::init()
+{
+    m_feasible = -1;
+    for (int s = 0; s < m_fleet->nShips(); s++)
+        m_order.push_back(s);
+    const FleetCatalog& fleet = *m_fleet;
+    stable_sort(m_order.begin(), m_order.end(),
+                [&fleet](int a, int b) { return fleet.shipLength(a) > fleet.shipLength(b); });
+    if (m_spacing <= 0)
+        return;
+
+    for (int s = 0; s < fleet.nShips(); s++)
+        m_zones.push_back(spacingZones(fleet, s, m_spacing));
+}
+
+//A ship's zones depend only on the board size, its length and the spacing,
+//so each set is built once and shared by every sampler that needs it
+shared_ptr<const vector<Bitboard> > FleetSampler::spacingZones(const FleetCatalog& fleet,
+                                                               int shipId, int spacing)
+{
+    static mutex cacheMutex;
+    static map<vector<int>, shared_ptr<const vector<Bitboard> > > cache;
+    vector<int> key;
+    key.push_back(fleet.rows());
+    key.push_back(fleet.cols());
+    key.push_back(fleet.shipLength(shipId));
+    key.push_back(spacing);
+    lock_guard<mutex> lock(cacheMutex);
+    shared_ptr<const vector<Bitboard> >& cached = cache[key];
+    if (cached == nullptr)
+    {
+        //Dilate each placement along rows and columns
+        Bitboard board = Bitboard::area(fleet.rows(), fleet.cols());
+        const vector<Placement>& placements = fleet.placements(shipId);
+        shared_ptr<vector<Bitboard> > zones = make_shared<vector<Bitboard> >();
+        zones->reserve(placements.size());
+        for (size_t i = 0; i < placements.size(); i++)
+        {
+            const Bitboard& mask = placements[i].mask;
+            Bitboard zone = mask;
+            for (int d = 1; d <= spacing; d++)
+                zone |= mask.shifted(0, d) | mask.shifted(0, -d) |
+                        mask.shifted(d, 0) | mask.shifted(-d, 0);
+            zones->push_back(zone & board);
+        }
+        cached = zones;
+    }
+    return cached;
+}
+
+bool FleetSampler::feasible()
+{
+    if (m_feasible >= 0)
+        return m_feasible == 1;
+    static mutex cacheMutex;
+    static map<vector<int>, bool> cache;
+    vector<int> key;
+    key.push_back(m_fleet->rows());
+    key.push_back(m_fleet->cols());
+    key.push_back(max(m_spacing, 0));
+    for (int s = 0; s < nShips(); s++)
+        key.push_back(m_fleet->shipLength(s));
+    lock_guard<mutex> lock(cacheMutex);
+    map<vector<int>, bool>::const_iterator it = cache.find(key);
+    if (it == cache.end())
+    {
+        //A search too big to finish proves nothing, so the draws go ahead
+        long long nodesLeft = 10000000;
+        it = cache.insert(make_pair(key, findLayout(0, Bitboard(), nodesLeft) != 0)).first;
+    }
+    m_feasible = (it->second ? 1 : 0);
+    return it->second;
+}
+
+//Place ships m_order[k] onwards in turn, backtracking on conflicts: 1 if a
+//legal layout turns up, 0 if there's none, -1 if the node budget ran out
+int FleetSampler::findLayout(size_t k, Bitboard occupied, long long& nodesLeft) const
+{
+    if (k == m_order.size())
+        return 1;
+    int s = m_order[k];
+    const vector<Placement>& placements = m_fleet->placements(s);
+    for (size_t i = 0; i < placements.size(); i++)
+    {
+        if (--nodesLeft < 0)
+            return -1;
+        if ((m_spacing > 0 ? (*m_zones[s])[i] : placements[i].mask).intersects(occupied))
+            continue;
+        int found = findLayout(k + 1, occupied | placements[i].mask, nodesLeft);
+        if (found != 0)
+            return found;
+    }
+    return 0;
+}
+
+bool FleetSampler::sample(int* placementIds, int maxAttempts)
+{
+    if (!feasible())
+        return false;
+    for (int attempt = 0; attempt < maxAttempts; attempt++)
+    {
+        Bitboard occupied;
+        size_t k;
+        for (k = 0; k < m_order.size(); k++)
+        {
+            //Draw this ship's placement; any conflict means starting the layout over
+            int s = m_order[k];
+            const vector<Placement>& placements = m_fleet->placements(s);
+            int i = randInt(int(placements.size()));
+            const Placement& p = placements[i];
+            //Spacing is symmetric, so keeping this ship's zone clear of the
+            //ships so far keeps it clear of theirs
+            if ((m_spacing > 0 ? (*m_zones[s])[i] : p.mask).intersects(occupied))
+                break;
+            occupied |= p.mask;
+            placementIds[s] = i;
+        }
+        if (k == m_order.size())
+            return true;
+    }
+    return false;
+}
+
+bool FleetSampler::placeShips(Board& b, int maxAttempts)
+{
+    int ids[MAXSHIPS];
+    if (!feasible())
+        return false;
+    if (!sample(ids, maxAttempts))
+    {
+        //A dense fleet rarely survives random draws; search for a layout instead
+        if (m_spacing > 0)
+            return false;
+        ExactCoverPlacer placer(m_fleet);
+        return placer.placeShips(b);
+    }
+    for (int s = 0; s < nShips(); s++)
+    {
+        const Placement& p = placement(s, ids[s]);
+        if (!b.placeShip(p.topOrLeft, s, p.dir))
+        {
+            b.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+//******************** Knowledge ********************************
+
+//Wasted shots teach nothing, so only valid shots are recorded
+void Knowledge::record(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (!validShot)
+        return;
+    shot.set(cellIndex(p));
+    if (shotHit)
+        hit.set(cellIndex(p));
+    if (shipDestroyed  &&  shipId >= 0  &&  shipId < int(sunkAt.size()))
+        sunkAt[shipId] = static_cast<signed char>(cellIndex(p));
+}
+
+bool Knowledge::allSunk() const
+{
+    for (size_t s = 0; s < sunkAt.size(); s++)
+        if (sunkAt[s] < 0)
+            return false;
+    return true;
+}
+
+bool Knowledge::consistentWith(const Bitboard* shipMasks) const
+{
+    Bitboard missed = shot & ~hit;
+    Bitboard occupied;
+    for (size_t s = 0; s < sunkAt.size(); s++)
+    {
+        const Bitboard& mask = shipMasks[s];
+        //No ship may sit under a miss
+        if (mask.intersects(missed))
+            return false;
+        //A destroyed ship was completely hit, and the last hit was where it sank;
+        //a ship still afloat must have at least one cell not yet hit
+        if (sunkAt[s] >= 0)
+        {
+            if (!hit.contains(mask)  ||  !mask.test(sunkAt[s]))
+                return false;
+        }
+        else if (hit.contains(mask))
+            return false;
+        occupied |= mask;
+    }
+    //Every hit must have landed on some ship
+    return occupied.contains(hit);
+}
+
+uint64_t Knowledge::hash() const
+{
+    uint64_t h = shot.hash() ^ (hit.hash() * 0xFF51AFD7ED558CCDULL);
+    for (size_t s = 0; s < sunkAt.size(); s++)
+        h = (h ^ uint64_t(sunkAt[s] + 1)) * 0x100000001B3ULL;
+    return h;
+}
@@ -0,0 +1,142 @@
+#ifndef FLEET_INCLUDED
+#define FLEET_INCLUDED
+
+#include "Bitboard.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+class Game;
+class Board;
+
+  // One way a ship can lie on the board
+class Placement
+{
+  public:
+    Placement() : dir(HORIZONTAL) {}
+    Placement(Point p, Direction d, Bitboard m) : topOrLeft(p), dir(d), mask(m) {}
+    Point topOrLeft;
+    Direction dir;
+    Bitboard mask;
+};
+
+  // Every placement of a ship of the given length that fits on g's board.
+  // A ship of length 1 only gets horizontal placements, so that no layout
+  // is counted twice.
+std::vector<Placement> shipPlacements(int nRows, int nCols, int length);
+std::vector<Placement> shipPlacements(const Game& g, int length);
+
+  // Everything about a game's board and fleet that doesn't change once the
+  // ships have been added: the board size, each ship's length, symbol and
+  // name, and every placement of every ship.  A catalog is never modified
+  // after it's built, so any number of games, on any threads, can share
+  // one through a shared_ptr instead of each keeping its own copy.
+class FleetCatalog
+{
+  public:
+    FleetCatalog(int nRows, int nCols);
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int nShips() const { return int(m_ships.size()); }
+    int shipLength(int shipId) const { return m_ships[shipId].length; }
+    char shipSymbol(int shipId) const { return m_ships[shipId].symbol; }
+    const std::string& shipName(int shipId) const { return m_ships[shipId].name; }
+    const std::vector<Placement>& placements(int shipId) const
+    {
+        return m_ships[shipId].placements;
+    }
+      // Which of shipId's placements has this top or left cell and
+      // direction, or -1 if that placement doesn't fit on the board
+    int placementIndex(int shipId, Point topOrLeft, Direction dir) const;
+      // A new catalog with one more ship
+    std::shared_ptr<const FleetCatalog> withShip(int length, char symbol,
+                                                 const std::string& name) const;
+
+  private:
+    struct Ship
+    {
+        int length;
+        char symbol;
+        std::string name;
+        std::vector<Placement> placements;
+        std::vector<short> index;  // by 2*cell+dir, into placements
+    };
+    int m_rows;
+    int m_cols;
+    std::vector<Ship> m_ships;
+};
+
+  // Draws fleet layouts uniformly at random from all the legal ones: every
+  // ship on the board, no two overlapping, and, if spacing is positive, no
+  // cell of a ship within spacing cells of another ship along a row or
+  // column.  Each ship's placement is drawn independently and the whole
+  // layout is redrawn if any of them conflict, which keeps every legal
+  // layout equally likely.
+class FleetSampler
+{
+  public:
+    FleetSampler(const Game& g, int spacing = 0);
+    FleetSampler(std::shared_ptr<const FleetCatalog> fleet, int spacing = 0);
+    int nShips() const { return m_fleet->nShips(); }
+    const Placement& placement(int shipId, int i) const { return m_fleet->placements(shipId)[i]; }
+      // Fill placementIds (one entry per ship) with a random legal layout,
+      // giving up after maxAttempts draws
+    bool sample(int* placementIds, int maxAttempts);
+      // Put a random legal layout on b.  If there's no spacing and
+      // maxAttempts draws all fail, fall back on an exact cover search,
+      // which finds a layout if there is one, though not uniformly.
+    bool placeShips(Board& b, int maxAttempts);
+      // False if no legal layout exists, in which case sample and
+      // placeShips fail at once instead of drawing.  It's worked out by a
+      // search the first time any sampler asks about that board size, those
+      // ship lengths and that spacing, and remembered after that.
+    bool feasible();
+
+  private:
+    std::shared_ptr<const FleetCatalog> m_fleet;
+    std::vector<int> m_order;   // longest ship first, so conflicts show up early
+    int m_spacing;
+    int m_feasible;             // 1 if a legal layout exists, 0 if none, -1 if not yet known
+      // Per ship and placement, the cells no other ship may use: the
+      // placement's cells and those within the spacing of them along a
+      // row or column.  They're shared by every sampler with the same board
+      // size, ship lengths and spacing.
+    std::vector<std::shared_ptr<const std::vector<Bitboard> > > m_zones;
+    void init();
+    static std::shared_ptr<const std::vector<Bitboard> > spacingZones(
+                                    const FleetCatalog& fleet, int shipId, int spacing);
+    int findLayout(std::size_t k, Bitboard occupied, long long& nodesLeft) const;
+};
+
+  // What one player has learned about the opponent's fleet from its shots:
+  // which cells were shot, which of those hit, and for each ship the cell
+  // whose shot destroyed it (-1 if it's still afloat).
+class Knowledge
+{
+  public:
+    Knowledge() {}
+    Knowledge(int nShips) : sunkAt(nShips, -1) {}
+    Bitboard shot;
+    Bitboard hit;
+    std::vector<signed char> sunkAt;
+
+    void record(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    bool allSunk() const;
+      // True if ships at these placements (one per ship) could have
+      // produced exactly the results recorded so far
+    bool consistentWith(const Bitboard* shipMasks) const;
+    std::uint64_t hash() const;
+    friend bool operator==(const Knowledge& a, const Knowledge& b)
+    {
+        return a.shot == b.shot  &&  a.hit == b.hit  &&  a.sunkAt == b.sunkAt;
+    }
+};
+
+struct KnowledgeHash
+{
+    std::size_t operator()(const Knowledge& k) const { return std::size_t(k.hash()); }
+};
+
+#endif // FLEET_INCLUDED
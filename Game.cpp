@@ -2,10 +2,14 @@
 #include "Board.h"
 #include "Player.h"
 #include "globals.h"
+#include "Fleet.h"
+#include "Trace.h"
+#include "Alloc.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
+#include <chrono>
 
 using namespace std;
 
@@ -13,6 +17,7 @@ class GameImpl
 {
 public:
     GameImpl(int nRows, int nCols);
+    GameImpl(shared_ptr<const FleetCatalog> fleet);
     int rows() const;
     int cols() const;
     bool isValid(Point p) const;
@@ -21,15 +26,26 @@ public:
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
-    string shipName(int shipId) const;
-    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    const string& shipName(int shipId) const;
+    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause,
+                 bool verbose, GameRecord& record);
+    Player* playSalvo(Player* p1, Player* p2, Board& b1, Board& b2, int shotsPerTurn,
+                      GameRecord& record);
+    void setObserver(GameObserver* obs);
+    shared_ptr<const FleetCatalog> catalog() const;
+    void setMoveBudget(long long micros);
+    void setLimits(const GameLimits& limits);
+    const GameLimits& limits() const;
 private:
     int m_rows;
     int m_cols;
-    int m_nShips = 0;
-    int m_shipLength[100];
-    int m_shipSymbol[100];
-    string m_shipName[100];
+    shared_ptr<const FleetCatalog> m_fleet;  //Ships, possibly shared with other games
+    GameObserver* m_observer = nullptr;
+    long long m_moveBudget = 0;
+    GameLimits m_limits;
+
+    Point timedAttack(Player* p, int seat, GameRecord& record) const;
+    Player* stopEarly(Player* p1, Player* p2, const GameRecord& record, bool verbose) const;
     
     //Board m_board;
     
@@ -46,6 +62,24 @@ GameImpl::GameImpl(int nRows, int nCols)
 {
     m_rows = nRows;
     m_cols = nCols;
+    m_fleet = make_shared<FleetCatalog>(nRows, nCols);
+}
+
+GameImpl::GameImpl(shared_ptr<const FleetCatalog> fleet)
+{
+    m_rows = fleet->rows();
+    m_cols = fleet->cols();
+    m_fleet = fleet;
+}
+
+shared_ptr<const FleetCatalog> GameImpl::catalog() const
+{
+    return m_fleet;
+}
+
+void GameImpl::setObserver(GameObserver* obs)
+{
+    m_observer = obs;
 }
 
 //Returns row
@@ -72,105 +106,352 @@ Point GameImpl::randomPoint() const
     return Point(randInt(rows()), randInt(cols()));
 }
 
-//Sets private variables at the proper index
+//Replaces the catalog with one that has the new ship; games already sharing the old one are unaffected
 bool GameImpl::addShip(int length, char symbol, string name)
 {
-    m_shipLength[m_nShips] = length;
-    m_shipSymbol[m_nShips] = symbol;
-    m_shipName[m_nShips] = name;
-    m_nShips++;
+    m_fleet = m_fleet->withShip(length, symbol, name);
     return true;
 }
 
 //Simply returns number of hsips
 int GameImpl::nShips() const
 {
-    return m_nShips;;
+    return m_fleet->nShips();
 }
 
 //Returns length of ship
 int GameImpl::shipLength(int shipId) const
 {
-    return m_shipLength[shipId];
+    return m_fleet->shipLength(shipId);
 }
 
 //Returns symbol of ship
 char GameImpl::shipSymbol(int shipId) const
 {
-    return m_shipSymbol[shipId];
+    return m_fleet->shipSymbol(shipId);
 }
 
 //Returns name of ship
-string GameImpl::shipName(int shipId) const
+const string& GameImpl::shipName(int shipId) const
 {
-    return m_shipName[shipId];
+    return m_fleet->shipName(shipId);
 }
 
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause)
+GameRecord::GameRecord()
 {
-    //Places ship for player 1 and 2, if ships cannot be placed, game ends by returning nullptr
-    if (!p1->placeShips(b1))
+    clear();
+}
+
+void GameRecord::clear()
+{
+    winner = -1;
+    outcome = UNFINISHED;
+    for (int seat = 0; seat < 2; seat++)
+    {
+        shots[seat] = 0;
+        hits[seat] = 0;
+        wasted[seat] = 0;
+        maxMoveMicros[seat] = 0;
+        slowMoves[seat] = 0;
+        for (int s = 0; s < MAXSHIPS; s++)
+            sinkTurn[seat][s] = -1;
+    }
+}
+
+//Tally one shot by the player in the given seat
+void GameRecord::addShot(int seat, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    shots[seat]++;
+    if (!validShot)
+        wasted[seat]++;
+    else if (shotHit)
+        hits[seat]++;
+    if (shipDestroyed  &&  shipId >= 0  &&  shipId < MAXSHIPS)
+        sinkTurn[seat][shipId] = shots[seat];
+}
+
+void ObserverGroup::add(GameObserver* obs)
+{
+    m_observers.push_back(obs);
+}
+
+void ObserverGroup::shipsPlaced(const Board& b1, const Board& b2)
+{
+    for (size_t i = 0; i < m_observers.size(); i++)
+        m_observers[i]->shipsPlaced(b1, b2);
+}
+
+void ObserverGroup::shotFired(int seat, Point p, bool validShot, bool shotHit,
+                              bool shipDestroyed, int shipId)
+{
+    for (size_t i = 0; i < m_observers.size(); i++)
+        m_observers[i]->shotFired(seat, p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+void ObserverGroup::gameOver(int winner)
+{
+    for (size_t i = 0; i < m_observers.size(); i++)
+        m_observers[i]->gameOver(winner);
+}
+
+void GameRecord::addMoveTime(int seat, long long micros, bool overBudget)
+{
+    if (micros > maxMoveMicros[seat])
+        maxMoveMicros[seat] = micros;
+    if (overBudget)
+        slowMoves[seat]++;
+}
+
+void GameImpl::setMoveBudget(long long micros)
+{
+    m_moveBudget = micros;
+}
+
+void GameImpl::setLimits(const GameLimits& limits)
+{
+    m_limits = limits;
+}
+
+const GameLimits& GameImpl::limits() const
+{
+    return m_limits;
+}
+
+//******************** GameWatchdog ********************************
+
+static long long steadyMicros()
+{
+    return chrono::duration_cast<chrono::microseconds>(
+                            chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+GameWatchdog::GameWatchdog(const GameLimits& limits)
+ : m_limits(limits), m_startMicros(0)
+{
+    m_armed = limits.maxTurns > 0  ||  limits.maxWasted > 0  ||  limits.maxMillis > 0;
+    if (limits.maxMillis > 0)
+        m_startMicros = steadyMicros();
+}
+
+bool GameWatchdog::check(int seat, int turn, GameRecord& record) const
+{
+    //A player who keeps wasting shots loses; running out of turns or time is nobody's win
+    if (m_limits.maxWasted > 0  &&  record.wasted[seat] > m_limits.maxWasted)
+    {
+        record.winner = 1 - seat;
+        record.outcome = GameRecord::FORFEIT;
+        return true;
+    }
+    //Both players get the same number of turns before the turn limit applies
+    if ((m_limits.maxTurns > 0  &&  seat == 1  &&  turn >= m_limits.maxTurns)  ||
+        (m_limits.maxMillis > 0  &&  steadyMicros() - m_startMicros >= 1000 * m_limits.maxMillis))
+    {
+        record.winner = -1;
+        record.outcome = GameRecord::TIMEOUT;
+        return true;
+    }
+    return false;
+}
+
+//End a game the watchdog stopped, returning the winner, if any
+Player* GameImpl::stopEarly(Player* p1, Player* p2, const GameRecord& record, bool verbose) const
+{
+    Player* winner = (record.winner == 0 ? p1 : record.winner == 1 ? p2 : nullptr);
+    if (verbose)
+    {
+        if (record.outcome == GameRecord::FORFEIT)
+            cout << (winner == p1 ? p2 : p1)->name() << " forfeits by wasting too many shots. "
+                 << winner->name() << " wins!" << endl;
+        else
+            cout << "The game ran out of turns or time; nobody wins." << endl;
+    }
+    if (m_observer != nullptr)
+        m_observer->gameOver(record.winner);
+    return winner;
+}
+
+//Both players place their ships; false if either can't
+static bool placeFleets(Player* p1, Player* p2, Board& b1, Board& b2)
+{
+    TRACE_SPAN("placeShips");
+    return p1->placeShips(b1) && p2->placeShips(b2);
+}
+
+//Ask the player for its shot, timing how long it takes to decide
+Point GameImpl::timedAttack(Player* p, int seat, GameRecord& record) const
+{
+    TRACE_SPAN("recommendAttack");
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Point move = p->recommendAttack();
+    long long micros = chrono::duration_cast<chrono::microseconds>(
+                                            chrono::steady_clock::now() - start).count();
+    record.addMoveTime(seat, micros, m_moveBudget > 0  &&  micros > m_moveBudget);
+    return move;
+}
+
+Player* GameImpl::playSalvo(Player* p1, Player* p2, Board& b1, Board& b2, int shotsPerTurn,
+                            GameRecord& record)
+{
+    record.clear();
+    GameWatchdog watchdog(m_limits);
+    AllocationScope setup(ALLOC_SETUP);
+    if (!placeFleets(p1, p2, b1, b2))
+    {
+        if (m_observer != nullptr)
+            m_observer->gameOver(-1);
         return nullptr;
-    if (!p2->placeShips(b2))
+    }
+    if (m_observer != nullptr)
+        m_observer->shipsPlaced(b1, b2);
+
+    Player* players[2] = { p1, p2 };
+    Board* boards[2] = { &b1, &b2 };
+    Point salvo[MAXSALVO];
+    SalvoResult result;
+    int turns[2] = { 0, 0 };
+    AllocationScope play(ALLOC_PLAY);
+    for (int seat = 0; ; seat = 1 - seat)
+    {
+        Player* shooter = players[seat];
+        Board& target = *boards[1 - seat];
+        int k = shotsPerTurn > 0 ? shotsPerTurn : boards[seat]->shipsAfloat();
+        if (k > MAXSALVO)
+            k = MAXSALVO;
+        if (k > m_rows * m_cols)
+            k = m_rows * m_cols;
+
+        //Time choosing the whole salvo as one move
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        int n;
+        {
+            TRACE_SPAN("recommendAttacks");
+            n = shooter->recommendAttacks(salvo, k);
+        }
+        long long micros = chrono::duration_cast<chrono::microseconds>(
+                                            chrono::steady_clock::now() - start).count();
+        record.addMoveTime(seat, micros, m_moveBudget > 0  &&  micros > m_moveBudget);
+
+        n = target.attackBatch(salvo, n, result);
+        {
+            TRACE_SPAN("recordAttackResults");
+            shooter->recordAttackResults(salvo, n, result);
+        }
+        for (int i = 0; i < n; i++)
+        {
+            int shipId = result.isSunk(i) ? result.shipId[i] : -1;
+            record.addShot(seat, result.isValid(i), result.isHit(i), result.isSunk(i), shipId);
+            if (m_observer != nullptr)
+                m_observer->shotFired(seat, salvo[i], result.isValid(i), result.isHit(i),
+                                      result.isSunk(i), shipId);
+        }
+        if (target.allShipsDestroyed())
+        {
+            record.winner = seat;
+            record.outcome = GameRecord::FINISHED;
+            if (m_observer != nullptr)
+                m_observer->gameOver(seat);
+            return shooter;
+        }
+        if (watchdog.expired(seat, ++turns[seat], record))
+            return stopEarly(p1, p2, record, false);
+    }
+}
+
+Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause,
+                       bool verbose, GameRecord& record)
+{
+    record.clear();
+    GameWatchdog watchdog(m_limits);
+    AllocationScope setup(ALLOC_SETUP);
+    //Places ship for player 1 and 2, if ships cannot be placed, game ends by returning nullptr
+    if (!placeFleets(p1, p2, b1, b2))
+    {
+        if (m_observer != nullptr)
+            m_observer->gameOver(-1);
         return nullptr;
+    }
+    if (m_observer != nullptr)
+        m_observer->shipsPlaced(b1, b2);
     
     //Initialization
     bool validShot, shotHit, shipDestroyed;
     int shipId = -1 ;
+    AllocationScope play(ALLOC_PLAY);
     
     while (1) //While winner is not selected
     {
         // ************************ Player 1's turn ************************
         //Print & Display Board of P2 for P1
-        cout << p1->name() << "'s turn. Board for " << p2->name() << ":" << endl;
-        b2.display(p1->isHuman());
+        if (verbose)
+        {
+            cout << p1->name() << "'s turn. Board for " << p2->name() << ":" << endl;
+            b2.display(p1->isHuman());
+        }
         //Reset parameters
         validShot = false;
         shotHit = false;
         shipDestroyed = false;
         shipId = -1;
         //Attack and Record results
-        Point p1Move = p1->recommendAttack();
+        Point p1Move = timedAttack(p1, 0, record);
         validShot = b2.attack(p1Move, shotHit, shipDestroyed, shipId);
-        p1->recordAttackResult(p1Move, validShot, shotHit, shipDestroyed, shipId);
-        //Outputs to user the result of the attack and the resulting board
-        if (!validShot)
         {
-            //If show was valid
-            cout << p1->name() << " wasted a shot at (" << p1Move.r << "," << p1Move.c << ")." << endl;
+            TRACE_SPAN("recordAttackResult");
+            p1->recordAttackResult(p1Move, validShot, shotHit, shipDestroyed, shipId);
         }
-        else
+        record.addShot(0, validShot, shotHit, shipDestroyed, shipId);
+        if (m_observer != nullptr)
+            m_observer->shotFired(0, p1Move, validShot, shotHit, shipDestroyed, shipId);
+        //Outputs to user the result of the attack and the resulting board
+        if (verbose)
         {
-            cout << p1->name() << " attacked (" << p1Move.r << "," << p1Move.c << ") and ";
-
-            if (shotHit == false) //If missed
+            if (!validShot)
             {
-                cout << "missed, resulting in: " << endl;
+                //If show was valid
+                cout << p1->name() << " wasted a shot at (" << p1Move.r << "," << p1Move.c << ")." << endl;
             }
-            else if (shipDestroyed == true) //If ship was destroyed
+            else
             {
-                cout << "destroyed the " << shipName(shipId) << ", resulting in:" << endl;
-            }
-            else if (shotHit == true) //If hit ship but ship not destroyed
-            {
-                cout << "hit something, resulting in: " << endl;
+                cout << p1->name() << " attacked (" << p1Move.r << "," << p1Move.c << ") and ";
+
+                if (shotHit == false) //If missed
+                {
+                    cout << "missed, resulting in: " << endl;
+                }
+                else if (shipDestroyed == true) //If ship was destroyed
+                {
+                    cout << "destroyed the " << shipName(shipId) << ", resulting in:" << endl;
+                }
+                else if (shotHit == true) //If hit ship but ship not destroyed
+                {
+                    cout << "hit something, resulting in: " << endl;
+                }
+                b2.display(p1->isHuman());
             }
-            b2.display(p1->isHuman());
         }
         
         //Check if player 1 won by destroying all ships
         if (b2.allShipsDestroyed())
         {
             //If the losing player is human, display the winner's board, showing everything
-            cout << p1->name() << " wins!" << endl;
-            
-            if (p2->isHuman())
+            if (verbose)
             {
-                cout << "Here's where " << p1->name() << "'s ships were: " << endl;
-                b1.display(false);
+                cout << p1->name() << " wins!" << endl;
+                
+                if (p2->isHuman())
+                {
+                    cout << "Here's where " << p1->name() << "'s ships were: " << endl;
+                    b1.display(false);
+                }
             }
+            record.winner = 0;
+            record.outcome = GameRecord::FINISHED;
+            if (m_observer != nullptr)
+                m_observer->gameOver(0);
             return p1;
         }
+        if (watchdog.expired(0, record.shots[0], record))
+            return stopEarly(p1, p2, record, verbose);
         //Pause Game
         if (shouldPause)
             waitForEnter();
@@ -179,52 +460,73 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
         // ************************ Player 2's turn ************************
         
         //Print & Display Board of P1 for P2
-        cout << p2->name() << "'s turn. Board for " << p1->name() << ":" << endl;
-        b1.display(p2->isHuman());
+        if (verbose)
+        {
+            cout << p2->name() << "'s turn. Board for " << p1->name() << ":" << endl;
+            b1.display(p2->isHuman());
+        }
         //Reset parameters
         validShot = false;
         shotHit = false;
         shipDestroyed = false;
         shipId = -1;
         //Attack and record results
-        Point p2Move = p2->recommendAttack();
+        Point p2Move = timedAttack(p2, 1, record);
         validShot = b1.attack(p2Move, shotHit, shipDestroyed, shipId);
-        p2->recordAttackResult(p2Move, validShot, shotHit, shipDestroyed, shipId);
-        //Output to user the result of the attack and the resulting board
-        if (!validShot)
         {
-            cout << p2->name() << " wasted a shot at (" << p2Move.r << "," << p2Move.c << ")." << endl;
+            TRACE_SPAN("recordAttackResult");
+            p2->recordAttackResult(p2Move, validShot, shotHit, shipDestroyed, shipId);
         }
-        else
+        record.addShot(1, validShot, shotHit, shipDestroyed, shipId);
+        if (m_observer != nullptr)
+            m_observer->shotFired(1, p2Move, validShot, shotHit, shipDestroyed, shipId);
+        //Output to user the result of the attack and the resulting board
+        if (verbose)
         {
-            cout << p2->name() << " attacked (" << p2Move.r << "," << p2Move.c << ") and ";
-            if (shotHit == false) //If shot missed
-            {
-                cout << "missed, resulting in: " << endl;
-            }
-            else if (shipDestroyed == true) //If ship destroyed
+            if (!validShot)
             {
-                cout << "destroyed the " << shipName(shipId) << ", resulting in:" << endl;
+                cout << p2->name() << " wasted a shot at (" << p2Move.r << "," << p2Move.c << ")." << endl;
             }
-            else if (shotHit == true) //If hit part of ship but ship not destroyed
+            else
             {
-                cout << "hit something, resulting in: " << endl;
+                cout << p2->name() << " attacked (" << p2Move.r << "," << p2Move.c << ") and ";
+                if (shotHit == false) //If shot missed
+                {
+                    cout << "missed, resulting in: " << endl;
+                }
+                else if (shipDestroyed == true) //If ship destroyed
+                {
+                    cout << "destroyed the " << shipName(shipId) << ", resulting in:" << endl;
+                }
+                else if (shotHit == true) //If hit part of ship but ship not destroyed
+                {
+                    cout << "hit something, resulting in: " << endl;
+                }
+                b1.display(p2->isHuman());
             }
-            b1.display(p2->isHuman());
         }
         
         //If player 2 won by destroying all of p1's ships
         if (b1.allShipsDestroyed())
         {
              //If the losing player is human, display the winner's board, showing everything
-            cout << p2->name() << " wins!" << endl;
-            if (p1->isHuman())
+            if (verbose)
             {
-                cout << "Here's where " << p2->name() << "'s ships were: " << endl;
-                b2.display(false);
+                cout << p2->name() << " wins!" << endl;
+                if (p1->isHuman())
+                {
+                    cout << "Here's where " << p2->name() << "'s ships were: " << endl;
+                    b2.display(false);
+                }
             }
+            record.winner = 1;
+            record.outcome = GameRecord::FINISHED;
+            if (m_observer != nullptr)
+                m_observer->gameOver(1);
             return p2;
         }
+        if (watchdog.expired(1, record.shots[1], record))
+            return stopEarly(p1, p2, record, verbose);
         
         //Pause game
         if (shouldPause)
@@ -239,7 +541,7 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
 // These functions for the most part simply delegate to GameImpl's functions.
 // You probably don't want to change any of the code from this point down.
 
-Game::Game(int nRows, int nCols)
+static void checkBoardSize(int nRows, int nCols)
 {
     if (nRows < 1  ||  nRows > MAXROWS)
     {
@@ -251,9 +553,20 @@ Game::Game(int nRows, int nCols)
         cout << "Number of columns must be >= 1 and <= " << MAXCOLS << endl;
         exit(1);
     }
+}
+
+Game::Game(int nRows, int nCols)
+{
+    checkBoardSize(nRows, nCols);
     m_impl = new GameImpl(nRows, nCols);
 }
 
+Game::Game(shared_ptr<const FleetCatalog> fleet)
+{
+    checkBoardSize(fleet->rows(), fleet->cols());
+    m_impl = new GameImpl(fleet);
+}
+
 Game::~Game()
 {
     delete m_impl;
@@ -324,6 +637,46 @@ bool Game::addShip(int length, char symbol, string name)
     return m_impl->addShip(length, symbol, name);
 }
 
+shared_ptr<const FleetCatalog> Game::catalog() const
+{
+    return m_impl->catalog();
+}
+
+Player* Game::playSalvo(Player* p1, Player* p2, int shotsPerTurn, GameRecord* record)
+{
+    GameRecord local;
+    if (record == nullptr)
+        record = &local;
+    if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
+    {
+        record->clear();
+        return nullptr;
+    }
+    Board b1(*this);
+    Board b2(*this);
+    return m_impl->playSalvo(p1, p2, b1, b2, shotsPerTurn, *record);
+}
+
+void Game::setMoveBudget(long long micros)
+{
+    m_impl->setMoveBudget(micros);
+}
+
+void Game::setLimits(const GameLimits& limits)
+{
+    m_impl->setLimits(limits);
+}
+
+const GameLimits& Game::limits() const
+{
+    return m_impl->limits();
+}
+
+void Game::setObserver(GameObserver* obs)
+{
+    m_impl->setObserver(obs);
+}
+
 int Game::nShips() const
 {
     return m_impl->nShips();
@@ -341,7 +694,7 @@ char Game::shipSymbol(int shipId) const
     return m_impl->shipSymbol(shipId);
 }
 
-string Game::shipName(int shipId) const
+const string& Game::shipName(int shipId) const
 {
     assert(shipId >= 0  &&  shipId < nShips());
     return m_impl->shipName(shipId);
@@ -353,6 +706,22 @@ Player* Game::play(Player* p1, Player* p2, bool shouldPause)
         return nullptr;
     Board b1(*this);
     Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+    GameRecord record;
+    return m_impl->play(p1, p2, b1, b2, shouldPause, true, record);
+}
+
+Player* Game::playQuietly(Player* p1, Player* p2, GameRecord* record)
+{
+    GameRecord local;
+    if (record == nullptr)
+        record = &local;
+    if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
+    {
+        record->clear();
+        return nullptr;
+    }
+    Board b1(*this);
+    Board b2(*this);
+    return m_impl->play(p1, p2, b1, b2, false, false, *record);
 }
 
@@ -1,17 +1,104 @@
 #ifndef GAME_INCLUDED
 #define GAME_INCLUDED
 
+#include "globals.h"
 #include <string>
+#include <memory>
+#include <vector>
 #include <cassert>
 
-class Point;
 class Player;
+class Board;
 class GameImpl;
+class FleetCatalog;
+
+  // What happened in one game.  Seat 0 is the player who moved first.
+struct GameRecord
+{
+    enum Outcome
+    {
+        UNFINISHED,   // the ships couldn't be placed, or the game wasn't played
+        FINISHED,     // the winner sank every opposing ship
+        FORFEIT,      // the loser wasted more shots than the limit allows
+        TIMEOUT       // the turn or time limit ran out with no winner
+    };
+    GameRecord();
+    void clear();
+    void addShot(int seat, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    void addMoveTime(int seat, long long micros, bool overBudget);
+    int winner;                       // seat of the winner, or -1 if none
+    Outcome outcome;
+    int shots[2];
+    int hits[2];
+    int wasted[2];
+    int sinkTurn[2][MAXSHIPS];        // the seat's shot number that sank each
+                                      // opposing ship, or -1 if it survived
+    long long maxMoveMicros[2];       // longest the seat took to choose a shot
+    int slowMoves[2];                 // shots that took longer than the move budget
+};
+
+  // Limits that stop a runaway game.  A zero means no limit.
+struct GameLimits
+{
+    int maxTurns = 0;                 // turns each player may take
+    int maxWasted = 0;                // wasted shots a player may fire before forfeiting
+    long long maxMillis = 0;          // wall-clock time for the whole game
+};
+
+  // Applies a game's limits as it's played.  The clock starts when the
+  // watchdog is constructed.
+class GameWatchdog
+{
+  public:
+    GameWatchdog(const GameLimits& limits);
+      // Called after seat has taken its turn-th turn.  If the game must
+      // stop, fills in record's winner and outcome and returns true.
+    bool expired(int seat, int turn, GameRecord& record) const
+    {
+        return m_armed  &&  check(seat, turn, record);
+    }
+
+  private:
+    GameLimits m_limits;
+    bool m_armed;
+    long long m_startMicros;
+    bool check(int seat, int turn, GameRecord& record) const;
+};
+
+  // Something that wants to follow the games a Game plays, e.g. to record
+  // or display them.  Seat 0 is the player who moves first.
+class GameObserver
+{
+  public:
+    virtual ~GameObserver() {}
+    virtual void shipsPlaced(const Board& /* b1 */, const Board& /* b2 */) {}
+    virtual void shotFired(int /* seat */, Point /* p */, bool /* validShot */,
+                           bool /* shotHit */, bool /* shipDestroyed */,
+                           int /* shipId */) {}
+    virtual void gameOver(int /* winner */) {}
+};
+
+  // Passes everything it observes on to each of several observers
+class ObserverGroup : public GameObserver
+{
+  public:
+    void add(GameObserver* obs);
+    virtual void shipsPlaced(const Board& b1, const Board& b2);
+    virtual void shotFired(int seat, Point p, bool validShot, bool shotHit,
+                           bool shipDestroyed, int shipId);
+    virtual void gameOver(int winner);
+
+  private:
+    std::vector<GameObserver*> m_observers;
+};
 
 class Game
 {
   public:
     Game(int nRows, int nCols);
+      // A game whose board and ships are those of an existing catalog,
+      // which it shares rather than copies
+    Game(std::shared_ptr<const FleetCatalog> fleet);
     ~Game();
     int rows() const;
     int cols() const;
@@ -21,8 +108,27 @@ class Game
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
-    std::string shipName(int shipId) const;
+    const std::string& shipName(int shipId) const;
+      // The board size and ships as they stand, for sharing with other games
+    std::shared_ptr<const FleetCatalog> catalog() const;
     Player* play(Player* p1, Player* p2, bool shouldPause = true);
+      // Like play, but with no output and no pauses, for AI-vs-AI runs.  If
+      // record isn't null, it's filled in with what happened.
+    Player* playQuietly(Player* p1, Player* p2, GameRecord* record = nullptr);
+      // Play quietly in salvo mode: each turn a player fires shotsPerTurn
+      // shots at once, or if that's 0, one shot per ship it has afloat
+    Player* playSalvo(Player* p1, Player* p2, int shotsPerTurn,
+                      GameRecord* record = nullptr);
+      // Report every game this Game plays from now on to obs (or to no one
+      // if it's null)
+    void setObserver(GameObserver* obs);
+      // Count as slow in each game's record any shot a player takes longer
+      // than this many microseconds to choose (0, the default, for none)
+    void setMoveBudget(long long micros);
+      // Stop each game this Game plays from now on once it runs past these
+      // limits, recording it as a forfeit or a timeout
+    void setLimits(const GameLimits& limits);
+    const GameLimits& limits() const;
       // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
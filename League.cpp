@@ -0,0 +1,152 @@
+#include "League.h"
+#include "Game.h"
+#include "Player.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    //Types that need no human at the keyboard and can play on the board
+    vector<string> computerTypes(const LeagueOptions& options)
+    {
+        Game g(options.rows, options.cols);
+        if (options.addShips != nullptr)
+            options.addShips(g);
+        vector<string> result;
+        vector<string> all = playerTypes();
+        for (size_t i = 0; i < all.size(); i++)
+        {
+            Player* p = createPlayer(all[i], all[i], g);
+            if (p != nullptr  &&  !p->isHuman()  &&  playerTypeSuits(all[i], g))
+                result.push_back(all[i]);
+            delete p;
+        }
+        return result;
+    }
+
+    //Fit Bradley-Terry strengths to the win counts with the MM algorithm
+    vector<double> fitBradleyTerry(const vector< vector<long long> >& beat)
+    {
+        size_t n = beat.size();
+        vector<double> strength(n, 1);
+        for (int iteration = 0; iteration < 1000; iteration++)
+        {
+            vector<double> next(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                long long wins = 0;
+                double denominator = 0;
+                for (size_t j = 0; j < n; j++)
+                {
+                    if (j == i)
+                        continue;
+                    wins += beat[i][j];
+                    long long games = beat[i][j] + beat[j][i];
+                    if (games > 0)
+                        denominator += games / (strength[i] + strength[j]);
+                }
+                //Keep a player who never won at a tiny but nonzero strength
+                next[i] = denominator > 0 ? max(double(wins), 0.01) / denominator : strength[i];
+            }
+            //Normalize to a geometric mean of 1
+            double logMean = 0;
+            for (size_t i = 0; i < n; i++)
+                logMean += log(next[i]) / n;
+            for (size_t i = 0; i < n; i++)
+                strength[i] = next[i] / exp(logMean);
+        }
+        return strength;
+    }
+}
+
+vector<LeagueEntry> runLeague(const LeagueOptions& options)
+{
+    vector<string> types = options.types.empty() ? computerTypes(options) : options.types;
+    size_t n = types.size();
+
+    //Each pairing is a match with its own seed, all sharing one fleet
+    MatchOptions fleetOptions;
+    fleetOptions.rows = options.rows;
+    fleetOptions.cols = options.cols;
+    fleetOptions.addShips = options.addShips;
+    shared_ptr<const FleetCatalog> fleet = matchFleet(fleetOptions);
+    vector<MatchOptions> pairings;
+    vector< pair<int, int> > players;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = i + 1; j < n; j++)
+        {
+            MatchOptions match;
+            match.rows = options.rows;
+            match.cols = options.cols;
+            match.addShips = options.addShips;
+            match.fleet = fleet;
+            match.typeA = types[i];
+            match.typeB = types[j];
+            match.seed = gameSeed(options.seed, pairings.size());
+            pairings.push_back(match);
+            players.push_back(make_pair(int(i), int(j)));
+        }
+
+    vector<LeagueEntry> table(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        table[i].type = types[i];
+        table[i].elo = 1500;
+        table[i].games = 0;
+        table[i].wins = 0;
+    }
+    vector< vector<long long> > beat(n, vector<long long>(n, 0));
+    if (pairings.empty())
+        return table;
+
+    //Game number k is game k / nPairings of pairing k % nPairings
+    long long nPairings = pairings.size();
+    typedef pair<GameRecord, int> Played;  // the record and the seat A sat in
+    parallelInOrder<Played>(nPairings * options.gamesPerPairing, options.nThreads,
+        [&](long long k) {
+            Played played;
+            played.second = playMatchGame(pairings[k % nPairings], k / nPairings,
+                                          played.first);
+            return played;
+        },
+        [&](long long k, const Played& played) {
+            if (played.first.winner < 0)
+                return true;
+            int a = players[k % nPairings].first;
+            int b = players[k % nPairings].second;
+            bool aWon = (played.first.winner == played.second);
+            int winner = aWon ? a : b;
+            int loser = aWon ? b : a;
+            table[a].games++;
+            table[b].games++;
+            table[winner].wins++;
+            beat[winner][loser]++;
+            double expected = 1 / (1 + pow(10, (table[loser].elo - table[winner].elo) / 400));
+            table[winner].elo += options.kFactor * (1 - expected);
+            table[loser].elo -= options.kFactor * (1 - expected);
+            return true;
+        });
+
+    vector<double> strength = fitBradleyTerry(beat);
+    for (size_t i = 0; i < n; i++)
+        table[i].bradleyTerry = 1500 + 400 * log10(strength[i]);
+    sort(table.begin(), table.end(),
+         [](const LeagueEntry& x, const LeagueEntry& y) { return x.elo > y.elo; });
+    return table;
+}
+
+void printLeague(ostream& out, const vector<LeagueEntry>& table)
+{
+    out << left << setw(12) << "Player" << right << setw(8) << "Elo"
+        << setw(8) << "BT" << setw(8) << "Games" << setw(8) << "Wins" << endl;
+    for (size_t i = 0; i < table.size(); i++)
+        out << left << setw(12) << table[i].type << right << fixed << setprecision(0)
+            << setw(8) << table[i].elo << setw(8) << table[i].bradleyTerry
+            << setw(8) << table[i].games << setw(8) << table[i].wins << endl;
+    out.unsetf(ios::fixed);
+    out << setprecision(6);
+}
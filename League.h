@@ -0,0 +1,39 @@
+#ifndef LEAGUE_INCLUDED
+#define LEAGUE_INCLUDED
+
+#include "Tournament.h"
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+struct LeagueOptions
+{
+    int rows = 10;
+    int cols = 10;
+    FleetSetup addShips = nullptr;
+    std::vector<std::string> types;     // empty means every non-human type
+    long long gamesPerPairing = 100;
+    int nThreads = 0;                   // 0 means one per hardware thread
+    unsigned long long seed = 1;
+    double kFactor = 16;                // Elo update step
+};
+
+struct LeagueEntry
+{
+    std::string type;
+    double elo;             // updated game by game
+    double bradleyTerry;    // fitted to all results at the end, on the Elo scale
+    long long games;
+    long long wins;
+};
+
+  // Play every type against every other type, gamesPerPairing games each,
+  // alternating seats.  Games from all pairings are interleaved and played
+  // in parallel; Elo ratings are updated in game order, so the table
+  // doesn't depend on the number of threads.  Returns the table sorted by
+  // Elo rating.
+std::vector<LeagueEntry> runLeague(const LeagueOptions& options);
+
+void printLeague(std::ostream& out, const std::vector<LeagueEntry>& table);
+
+#endif // LEAGUE_INCLUDED
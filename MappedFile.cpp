@@ -0,0 +1,72 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_MMAP
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile()
+ : m_data(nullptr), m_size(0), m_mapped(false)
+{}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const string& path)
+{
+    close();
+#ifdef HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_size = size_t(info.st_size);
+    if (m_size > 0)
+    {
+        void* p = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close(fd);
+            m_size = 0;
+            return false;
+        }
+        m_data = static_cast<const unsigned char*>(p);
+        m_mapped = true;
+    }
+    ::close(fd);  //The mapping stays valid after the descriptor is closed
+    return true;
+#else
+    ifstream in(path.c_str(), ios::binary);
+    if (!in)
+        return false;
+    m_buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    m_data = m_buffer.empty() ? nullptr : &m_buffer[0];
+    m_size = m_buffer.size();
+    return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef HAVE_MMAP
+    if (m_mapped)
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
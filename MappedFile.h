@@ -0,0 +1,31 @@
+#ifndef MAPPEDFILE_INCLUDED
+#define MAPPEDFILE_INCLUDED
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+  // A read-only view of a whole file.  On POSIX systems the file is mapped
+  // into memory, so only the pages actually touched are ever read; elsewhere
+  // it's simply read in.
+class MappedFile
+{
+  public:
+    MappedFile();
+    ~MappedFile();
+    bool open(const std::string& path);
+    void close();
+    const unsigned char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+      // We prevent a MappedFile object from being copied or assigned
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+  private:
+    const unsigned char* m_data;
+    std::size_t m_size;
+    bool m_mapped;
+    std::vector<unsigned char> m_buffer;
+};
+
+#endif // MAPPEDFILE_INCLUDED
@@ -2,17 +2,70 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "Fleet.h"
+#include "Solver.h"
+#include "DensityMap.h"
+#include "Endgame.h"
+#include "FastPlay.h"
+#include <map>
+#include <utility>
 #include <vector>
 #include <iostream>
 #include <string>
 
 using namespace std;
 
+//*********************************************************************
+//  Player
+//*********************************************************************
+
+//Ask for one shot at a time, steering clear of cells already in the salvo
+int Player::recommendAttacks(Point* points, int k)
+{
+    int n = 0;
+    while (n < k)
+    {
+        Point p = recommendAttack();
+        bool fresh = !inSalvo(points, n, p);
+        for (int tries = 0; !fresh  &&  tries < 100; tries++)
+        {
+            p = (tries < 50 ? recommendAttack() : game().randomPoint());
+            fresh = !inSalvo(points, n, p);
+        }
+        //Take the first cell not in the salvo yet; stop short if there's none
+        for (int r = 0; !fresh  &&  r < game().rows(); r++)
+            for (int c = 0; !fresh  &&  c < game().cols(); c++)
+            {
+                p = Point(r, c);
+                fresh = !inSalvo(points, n, p);
+            }
+        if (!fresh)
+            break;
+        points[n++] = p;
+    }
+    return n;
+}
+
+bool Player::inSalvo(const Point* points, int n, Point p)
+{
+    for (int j = 0; j < n; j++)
+        if (points[j].r == p.r  &&  points[j].c == p.c)
+            return true;
+    return false;
+}
+
+void Player::recordAttackResults(const Point* points, int n, const SalvoResult& result)
+{
+    for (int i = 0; i < n; i++)
+        recordAttackResult(points[i], result.isValid(i), result.isHit(i), result.isSunk(i),
+                           result.isSunk(i) ? result.shipId[i] : -1);
+}
+
 //*********************************************************************
 //  AwfulPlayer
 //*********************************************************************
 
-class AwfulPlayer : public Player
+class AwfulPlayer final : public Player
 {
   public:
     AwfulPlayer(string nm, const Game& g);
@@ -86,7 +139,7 @@ bool getLineWithTwoIntegers(int& r, int& c)
 //        implementation.
 // typedef AwfulPlayer HumanPlayer;
 
-class HumanPlayer : public Player
+class HumanPlayer final : public Player
 {
 public:
     HumanPlayer(string nm, const Game& g);
@@ -189,7 +242,7 @@ Point HumanPlayer::recommendAttack()
 //*********************************************************************
 
 
-class MediocrePlayer : public Player
+class MediocrePlayer final : public Player
 {
 public:
     MediocrePlayer(string nm, const Game& g);
@@ -201,69 +254,23 @@ private:
     int shipState = 1;
     Point m_lastCellAttacked;
     vector<Point> history;
-    bool placeShipsRecursive(Board &b, Point topOrLeft, int shipId);
-    Point incrementPoint(Point p);
+    FleetSampler m_sampler;
     bool notDestroyed(Point p);
     bool findInHistory(Point p);
 };
 
 MediocrePlayer::MediocrePlayer(string nm, const Game& g)
-: Player(nm, g), m_lastCellAttacked(0, 0)
+: Player(nm, g), m_lastCellAttacked(0, 0), m_sampler(g)
 {
+    //Room for a shot at every cell, so the history never grows during a game
+    history.reserve(g.rows() * g.cols());
 }
 
 
 bool MediocrePlayer::placeShips(Board &b)
 {
-    //Keep trying to place ship on board with different block configuration
-    for (int i = 0; i < 50; i++)
-    {
-        b.block();
-        if (placeShipsRecursive(b, Point(0,0), 0))
-        {
-            b.unblock();
-            return true;
-        }
-        b.clear();
-    }
-    return false;
-}
-
-//Increment Point, from left to right, then top to bottom
-Point MediocrePlayer::incrementPoint(Point p)
-{
-    if (p.c == game().cols() - 1)
-        return Point(p.r+1, 0);
-    else
-        return Point(p.r, p.c+1);
-}
-
-//New member function to place ships recursively
-bool MediocrePlayer::placeShipsRecursive(Board &b,Point topOrLeft, int shipId){
-    //All ships have been placed
-    if (shipId == game().nShips())
-        return true;
-    
-    //If point reaches bottom right corner, cannot be placed
-    if (topOrLeft.c == game().cols()-1 && topOrLeft.r == game().rows() - 1)
-        return false;
-    
-    //Try to place Horizontally
-    if ( b.placeShip(topOrLeft, shipId, HORIZONTAL) )
-        if (placeShipsRecursive(b, Point(0,0), shipId +1)) //See if next ship can be placed
-            return true;
-    b.unplaceShip(topOrLeft, shipId, HORIZONTAL); //Unplace ships if failed
-    
-    //Try to place Vertically
-    if (b.placeShip(topOrLeft, shipId, VERTICAL))
-        if (placeShipsRecursive(b, Point(0,0), shipId +1)) //See if next ship can be placed
-            return true;
-    b.unplaceShip(topOrLeft, shipId, VERTICAL); //Unplace ships if failed
-    
-    //Call function again, but increment location by one
-    Point newTopOrLeft = incrementPoint(topOrLeft);
-    return (placeShipsRecursive(b, newTopOrLeft, shipId));
-    
+    //Draw a random layout, every legal one being equally likely
+    return m_sampler.placeShips(b, 1000000);
 }
 
 //Checks if point exists in history of attack locations
@@ -305,19 +312,23 @@ Point MediocrePlayer::recommendAttack()
     //State 1: has not hit ship yet, attack random non-redundant locations
     if (shipState == 1)
     {
-        while (1)
+        //Give up after many more draws than there are cells; the watchdog ends such a game
+        for (int tries = 0; tries < 100 * game().rows() * game().cols(); tries++)
         {
             attackNext = game().randomPoint();
             if (!findInHistory(attackNext))
                 return attackNext;
         }
-        
+        return game().randomPoint();
     }
     
     //State 2: a shit has been hit, randomly hit up to 4 adjacent cells in all 4 directions
     if (shipState == 2)
     {
-        while(1)
+        //The same draws as ever, so games against "mediocre" are unchanged;
+        //notDestroyed above leaves this state once all 16 cells are used,
+        //and the bound is only a safeguard
+        for (int tries = 0; tries < 100 * game().rows() * game().cols(); tries++)
         {
             if (randInt(2) == 0)
                 attackNext = Point(m_lastCellAttacked.r + 4 - randInt(9),m_lastCellAttacked.c);
@@ -330,6 +341,8 @@ Point MediocrePlayer::recommendAttack()
             if (!findInHistory(attackNext))
                 return attackNext;
         }
+        shipState = 1;
+        return recommendAttack();
     }
     
     return Point(0,0); 
@@ -379,165 +392,41 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, b
 //  GoodPlayer
 //*********************************************************************
 
-class GoodPlayer : public Player
+class GoodPlayer final : public Player
 {
 public:
-    GoodPlayer(string nm, const Game& g);
+    GoodPlayer(string nm, const Game& g, const GoodPlayerParams& params = GoodPlayerParams());
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p) {}
 private:
+    GoodPlayerParams m_params;
     int numAtt = 0;
-    int m_ship[10][10]; //Own history of location of ships placed
     int shipState = 1;
     vector<Point> history;
-    bool shipPlacement(Board& b, int n, int shipId);
-    bool placeShipsRecursive(Board &b,Point topOrLeft, int shipId);
-    bool canPlace(Point p, int shipId, Direction dir);
+    FleetSampler m_spacedSampler; //Keeps ships apart by the spacing distance
+    FleetSampler m_sampler;
     bool findInHistory(Point p);
-    void unplace(Point p, int shipId, Direction dir);
-    void clear();
+    Point firstUnattacked();
     Point m_lastCellAttacked;
-    Point incrementPoint(Point p);
 };
 
 
-GoodPlayer::GoodPlayer(string nm, const Game& g)
-: Player(nm, g), m_lastCellAttacked(0, 0)
+GoodPlayer::GoodPlayer(string nm, const Game& g, const GoodPlayerParams& params)
+: Player(nm, g), m_params(params), m_spacedSampler(g, params.shipSpacing), m_sampler(g),
+  m_lastCellAttacked(0, 0)
 {
-    for (int r = 0; r < 10; r++)
-        for (int c = 0; c < 10; c++)
-            m_ship[r][c] = -1; //Sets personal grid to be all -1
-}
-
-//Clears personal grid
-void GoodPlayer::clear()
-{
-    for (int r = 0; r < 10; r++)
-        for (int c = 0; c < 10; c++)
-            m_ship[r][c] = -1; //Personal grid = -1
+    history.reserve(g.rows() * g.cols());
 }
 
 bool GoodPlayer::placeShips(Board &b)
 {
-    //Try to place ship 50 times with different locations blocked each time
-    for (int i = 0; i < 50; i++)
-    {
-        b.block();
-        if (placeShipsRecursive(b, Point(0,0), 0))
-        {
-            b.unblock();
-            return true;
-        }
-        b.clear();
-        clear();
-    }
-    return false;
-}
-
-//Increment location of point by one grid (left to right, top to bottom)
-Point GoodPlayer::incrementPoint(Point p)
-{
-    if (p.c == game().cols() - 1)
-        return Point(p.r+1, 0);
-    else
-        return Point(p.r, p.c+1);
-}
-
-//A function that sees if there are any ships that are exactly 4 steps vertical or horizontal from the
-//location of the current ship being placed
-bool GoodPlayer::canPlace(Point p, int shipId, Direction dir)
-{
-    //Placing ship on our personal grid
-    int shipLength = game().shipLength(shipId);
-    
-    if (dir == HORIZONTAL)
-        for (int i = 0; i < shipLength; i ++)
-            m_ship[p.r][p.c + i] = shipId;
-    
-    if (dir == VERTICAL)
-        for (int i = 0; i < shipLength; i ++)
-            m_ship[p.r + i][p.c] = shipId;
-    
-    //Check 4 positions vertically and horizontally, for each location of one ship
-    Point originalP = p;
-    for (int i = 0; i < shipLength; i++)
-    {
-        //In each iteration, check the different positions occupied by the ship
-        if (dir == HORIZONTAL)
-            p = Point(originalP.r,originalP.c+i);
-        else
-            p = Point(originalP.r+i,originalP.c);
-        
-        //Check 4 grids directly to the right and left
-        for (int j = 0; j < 9; j++)
-        {
-            if (p.c-4+j < 0 || p.c-4+j >= game().cols())
-                continue;
-            if (m_ship[p.r][p.c-4+j] != -1 && m_ship[p.r][p.c-4+j] != shipId)
-                return false;
-        }
-        
-        //Check 4 grids directly to the top and bottom
-        for ( int j = 0; j < 9; j++)
-        {
-            if (p.r-4+j < 0 || p.r-4+j >= game().rows())
-                continue;
-            if (m_ship[p.r-4+j][p.c] != -1 && m_ship[p.r-4+j][p.c] != shipId)
-                return false;
-        }
-        
-    }
-    return true;
-    
-}
-
-//Unplace ships indicated by the parameter
-void GoodPlayer::unplace(Point p, int shipId, Direction dir)
-{
-    if (dir == HORIZONTAL){
-        for (int i = 0; i < game().shipLength(shipId); i ++)
-            if (game().isValid(Point(p.r,p.c+i)))
-                if (m_ship[p.r][p.c+i] == shipId)
-                    m_ship[p.r][p.c+i] = -1;
-    }
-    else
-        for (int i = 0; i < game().shipLength(shipId); i ++)
-            if (game().isValid(Point(p.r+i,p.c)))
-                if (m_ship[p.r+i][p.c] == shipId)
-                    m_ship[p.r+i][p.c] = -1;
-}
-
-
-//Place ships recursively
-bool GoodPlayer::placeShipsRecursive(Board &b,Point topOrLeft, int shipId){
-    //if all ships have been placed, return true
-    if (shipId == game().nShips())
+    //Spread ships out so that no ship is within the spacing distance of another
+    //in the same row or column; if no such layout turns up, settle for any layout
+    if (m_spacedSampler.placeShips(b, m_params.placementAttempts))
         return true;
-    
-    //If point has reached bottom right corner of grid, ship placement unsuccessful, return false
-    if (topOrLeft.c == game().cols()-1 && topOrLeft.r == game().rows() - 1)
-        return false;
-    
-    //If horizontal ship can be placed and not within 4 units of another ship
-    if ( b.placeShip(topOrLeft, shipId, HORIZONTAL) && canPlace(topOrLeft, shipId, HORIZONTAL))
-        if (placeShipsRecursive(b, Point(0,0), shipId +1)) //Place next ship
-            return true;
-    b.unplaceShip(topOrLeft, shipId, HORIZONTAL); //If unsuccessful, remove ships from board
-    unplace(topOrLeft, shipId, HORIZONTAL); //If unsuccessful, remove ships from personal ship
-    
-    //Repeat for vertical ships
-    if (b.placeShip(topOrLeft, shipId, VERTICAL) && canPlace(topOrLeft, shipId, VERTICAL) )
-        if (placeShipsRecursive(b, Point(0,0), shipId +1))
-            return true;
-    b.unplaceShip(topOrLeft, shipId, VERTICAL);
-    unplace(topOrLeft, shipId, VERTICAL);
-    
-    //Increment location of ship by one unit
-    Point newTopOrLeft = incrementPoint(topOrLeft);
-    return (placeShipsRecursive(b, newTopOrLeft, shipId));
-    
+    return m_sampler.placeShips(b, 1000000);
 }
 
 //True if the point has already been attacked
@@ -549,47 +438,70 @@ bool GoodPlayer::findInHistory(Point p)
     return false;
 }
 
+//The first cell not attacked yet, for when random draws keep missing them
+Point GoodPlayer::firstUnattacked()
+{
+    for (int r = 0; r < game().rows(); r++)
+        for (int c = 0; c < game().cols(); c++)
+            if (!findInHistory(Point(r, c)))
+                return Point(r, c);
+    return game().randomPoint();
+}
+
 Point GoodPlayer::recommendAttack()
 {
     
     Point attackNext;
+    //Each search below gives up after many more draws than there are cells
+    int maxTries = 100 * game().rows() * game().cols();
     
-    //In random attack mode, attacks even squares
+    //In random attack mode, attacks even squares (or odd ones, if so configured)
     if (shipState == 1)
     {
-        int evenOdd = 0;
+        int evenOdd = m_params.parity;
         int count = 0;
-        while (1)
+        for (int tries = 0; tries < maxTries; tries++)
         {
             //For the rare case that somehow no ship can be found in even cells of board, change from even to odd cells
             count ++;
-            if (count > 50)
-                evenOdd = 1;
+            if (count > m_params.parityRetries)
+                evenOdd = 1 - m_params.parity;
             
             attackNext = game().randomPoint();
             //If attack is even square, and has not been attacked before
             if (!findInHistory(attackNext) && (attackNext.r + attackNext.c)%2 == evenOdd )
                 return attackNext;
         }
-        
+        return firstUnattacked();
     }
     
     //In alert mode, checks one unit in each direction to see if a ship is there
     if (shipState == 2)
     {
         int count = 0;
-        int dist1 = 1;
-        int dist2 = 3;
+        int dist1 = m_params.alertRadius;
+        int dist2 = 2*dist1 + 1;
 
-        while(1)
+        for (int tries = 0; ; tries++)
         {
+            if (tries >= maxTries)
+            {
+                shipState = 1;
+                break;
+            }
             count ++;
-            //If the even-squares were checked 50 times, choose squares randomly
-            if (count > 50)
+            //If the nearby squares were checked enough times, look further away
+            if (count > m_params.alertRetries)
             {
-                dist1 = dist1 + 1;
-                dist2 = dist2 + 2;
+                dist1 = dist1 + m_params.alertGrowth;
+                dist2 = 2*dist1 + 1;
                 count = 0;
+                //Every cell in the hit's row and column has been tried (which a salvo can cause), so go back to random mode
+                if (dist1 > game().rows() + game().cols())
+                {
+                    shipState = 1;
+                    break;
+                }
             }
             //Attack randomly N,E,S,W, or itself
             if (randInt(2) == 0)
@@ -606,6 +518,11 @@ Point GoodPlayer::recommendAttack()
         }
     }
     
+    //A salvo can leave the latest shot off the line through the hit, so look around the hit again
+    if ((shipState == 3 || shipState == 4) && history[history.size()-1].r != m_lastCellAttacked.r
+                                           && history[history.size()-1].c != m_lastCellAttacked.c)
+        shipState = 2;
+    
     //In attack mode, either continuously attacks right or bottom
     if (shipState == 3)
     {
@@ -690,14 +607,19 @@ Point GoodPlayer::recommendAttack()
         int count = 0;
         int dist1 = 1;
         int dist2 = 3;
-        while (1)
+        for (int tries = 0; ; tries++)
         {
+            if (tries >= maxTries)
+            {
+                shipState = 1;
+                break;
+            }
             count++;
-            if (count > 30)
+            if (count > m_params.searchRetries)
             {
                 dist1++;
                 dist2 = dist2 + 2;
-                if (dist1 == 4)
+                if (dist1 >= m_params.searchMaxRadius)
                 {
                     shipState = 1;
                     break;
@@ -848,16 +770,219 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool
 }
 
 
+//*********************************************************************
+//  OptimalPlayer
+//*********************************************************************
+
+class OptimalPlayer final : public Player
+{
+public:
+    OptimalPlayer(string nm, const Game& g);
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p) {}
+private:
+    shared_ptr<const OptimalSolver> m_solver;
+    Knowledge m_knowledge;
+};
+
+//Each board is solved once, by the first player on it; on boards too big to
+//solve, the player falls back to random play
+OptimalPlayer::OptimalPlayer(string nm, const Game& g)
+: Player(nm, g), m_solver(sharedOptimalSolver(g)), m_knowledge(g.nShips())
+{}
+
+bool OptimalPlayer::placeShips(Board& b)
+{
+    //Pick uniformly among all layouts, which is what the solver assumes of the opponent
+    if (m_solver->solved())
+    {
+        int layoutId = randInt(int(m_solver->nLayouts()));
+        for (int s = 0; s < game().nShips(); s++)
+        {
+            const Placement& placement = m_solver->placement(layoutId, s);
+            if (!b.placeShip(placement.topOrLeft, s, placement.dir))
+                return false;
+        }
+        return true;
+    }
+    
+    //Otherwise any random layout will do
+    FleetSampler sampler(game());
+    return sampler.placeShips(b, 1000000);
+}
+
+Point OptimalPlayer::recommendAttack()
+{
+    //Look up the best shot for what we know so far
+    int cell = m_solver->bestShot(m_knowledge);
+    if (cell >= 0)
+        return cellPoint(cell);
+    
+    //Not in the table, so shoot any cell we haven't shot yet
+    for (int tries = 0; tries < 100 * game().rows() * game().cols(); tries++)
+    {
+        Point attackNext = game().randomPoint();
+        if (!m_knowledge.shot.test(attackNext))
+            return attackNext;
+    }
+    Bitboard unshot = Bitboard::area(game().rows(), game().cols()) & ~m_knowledge.shot;
+    return unshot.any() ? cellPoint(unshot.lowest()) : game().randomPoint();
+}
+
+void OptimalPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    m_knowledge.record(p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+//*********************************************************************
+//  DensityPlayer
+//*********************************************************************
+
+class DensityPlayer final : public Player
+{
+public:
+    DensityPlayer(string nm, const Game& g);
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p) {}
+    virtual int recommendAttacks(Point* points, int k);
+private:
+    FleetSampler m_sampler;
+    DensityMap m_density;
+};
+
+DensityPlayer::DensityPlayer(string nm, const Game& g)
+: Player(nm, g), m_sampler(g), m_density(g.catalog())
+{
+}
+
+bool DensityPlayer::placeShips(Board& b)
+{
+    return m_sampler.placeShips(b, 1000000);
+}
+
+//Shoot where the most still-possible placements overlap, favoring those through open hits
+Point DensityPlayer::recommendAttack()
+{
+    int cell = m_density.bestCell();
+    if (cell >= 0)
+        return cellPoint(cell);
+    return game().randomPoint();
+}
+
+//A salvo takes the k best cells, since none of its results are known until it lands
+int DensityPlayer::recommendAttacks(Point* points, int k)
+{
+    Bitboard chosen;
+    int n = 0;
+    while (n < k)
+    {
+        int cell = m_density.bestCell(chosen);
+        if (cell < 0)
+            break;
+        chosen.set(cell);
+        points[n++] = cellPoint(cell);
+    }
+    return n;
+}
+
+void DensityPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    m_density.record(p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+
+//*********************************************************************
+//  EndgamePlayer
+//*********************************************************************
+
+class EndgamePlayer final : public Player
+{
+public:
+    EndgamePlayer(Player* inner, const Game& g, const EndgameParams& params);
+    virtual ~EndgamePlayer();
+    virtual bool isHuman() const { return m_inner->isHuman(); }
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+private:
+    Player* m_inner;
+    EndgameParams m_params;
+    EndgameEnumerator m_endgame;
+    Knowledge m_knowledge;
+};
+
+EndgamePlayer::EndgamePlayer(Player* inner, const Game& g, const EndgameParams& params)
+: Player(inner->name(), g), m_inner(inner), m_params(params), m_endgame(g.catalog()),
+  m_knowledge(g.nShips())
+{
+}
+
+EndgamePlayer::~EndgamePlayer()
+{
+    delete m_inner;
+}
+
+bool EndgamePlayer::placeShips(Board& b)
+{
+    return m_inner->placeShips(b);
+}
+
+//Take over once few layouts remain, unless enumerating them runs out of budget
+Point EndgamePlayer::recommendAttack()
+{
+    if (m_endgame.estimateLayouts(m_knowledge) <= m_params.maxEstimate)
+    {
+        EndgameEnumerator::Clock::time_point deadline = EndgameEnumerator::Clock::now() +
+                                            chrono::microseconds(m_params.maxMicros);
+        int cell = m_endgame.bestShot(m_knowledge, m_params.maxLayouts, deadline);
+        if (cell >= 0)
+            return cellPoint(cell);
+    }
+    return m_inner->recommendAttack();
+}
+
+//The wrapped player hears about every shot, including the ones it didn't choose
+void EndgamePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    m_knowledge.record(p, validShot, shotHit, shipDestroyed, shipId);
+    m_inner->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+void EndgamePlayer::recordAttackByOpponent(Point p)
+{
+    m_inner->recordAttackByOpponent(p);
+}
+
+
 //*********************************************************************
 //  createPlayer
 //*********************************************************************
 
+static const string types[] = {
+    "human", "awful", "mediocre", "good", "optimal", "density"
+};
+
+vector<string> playerTypes()
+{
+    return vector<string>(types, types + sizeof(types)/sizeof(types[0]));
+}
+
 Player* createPlayer(string type, string nm, const Game& g)
 {
-    static string types[] = {
-        "human", "awful", "mediocre", "good"
-    };
-    
+    static const string endgameSuffix = "+endgame";
+    if (type.size() > endgameSuffix.size()  &&
+        type.compare(type.size() - endgameSuffix.size(), string::npos, endgameSuffix) == 0)
+    {
+        Player* inner = createPlayer(type.substr(0, type.size() - endgameSuffix.size()), nm, g);
+        if (inner == nullptr)
+            return nullptr;
+        return createEndgamePlayer(inner, g, EndgameParams());
+    }
     int pos;
     for (pos = 0; pos != sizeof(types)/sizeof(types[0])  &&
                                                      type != types[pos]; pos++)
@@ -868,8 +993,81 @@ Player* createPlayer(string type, string nm, const Game& g)
       case 1:  return new AwfulPlayer(nm, g);
       case 2:  return new MediocrePlayer(nm, g);
       case 3:  return new GoodPlayer(nm, g);
+      case 4:  return new OptimalPlayer(nm, g);
+      case 5:  return new DensityPlayer(nm, g);
       default: return nullptr;
     }
 }
 
+bool playerTypeSuits(const string& type, const Game& g)
+{
+    if (type == "optimal"  ||  type == "optimal+endgame")
+        return sharedOptimalSolver(g)->solved();
+    return true;
+}
+
+Player* createGoodPlayer(string nm, const Game& g, const GoodPlayerParams& params)
+{
+    return new GoodPlayer(nm, g, params);
+}
+
+Player* createEndgamePlayer(Player* inner, const Game& g, const EndgameParams& params)
+{
+    return new EndgamePlayer(inner, g, params);
+}
+
+//*********************************************************************
+//  playKnownPairing
+//*********************************************************************
+
+typedef void (*PairingFunction)(const Game& g, const string& type1, const string& type2,
+                                GameRecord& record);
+
+template <class P1, class P2>
+static void playPairing(const Game& g, const string& type1, const string& type2,
+                        GameRecord& record)
+{
+    AllocationScope setup(ALLOC_SETUP);
+    P1 p1(type1, g);
+    P2 p2(type2, g);
+    Board b1(g);
+    Board b2(g);
+    playFast(p1, p2, b1, b2, record, g.limits());
+}
+
+//Every pairing with P1 moving first
+template <class P1>
+static void addPairings(map<pair<string, string>, PairingFunction>& table, const string& type1)
+{
+    table[make_pair(type1, string("awful"))] = &playPairing<P1, AwfulPlayer>;
+    table[make_pair(type1, string("mediocre"))] = &playPairing<P1, MediocrePlayer>;
+    table[make_pair(type1, string("good"))] = &playPairing<P1, GoodPlayer>;
+    table[make_pair(type1, string("optimal"))] = &playPairing<P1, OptimalPlayer>;
+    table[make_pair(type1, string("density"))] = &playPairing<P1, DensityPlayer>;
+}
+
+static map<pair<string, string>, PairingFunction> makePairingTable()
+{
+    map<pair<string, string>, PairingFunction> table;
+    addPairings<AwfulPlayer>(table, "awful");
+    addPairings<MediocrePlayer>(table, "mediocre");
+    addPairings<GoodPlayer>(table, "good");
+    addPairings<OptimalPlayer>(table, "optimal");
+    addPairings<DensityPlayer>(table, "density");
+    return table;
+}
+
+bool playKnownPairing(const string& type1, const string& type2, const Game& g,
+                      GameRecord& record)
+{
+    static const map<pair<string, string>, PairingFunction> table = makePairingTable();
+    map<pair<string, string>, PairingFunction>::const_iterator it =
+                                                    table.find(make_pair(type1, type2));
+    if (it == table.end()  ||  g.nShips() == 0  ||
+                            !playerTypeSuits(type1, g)  ||  !playerTypeSuits(type2, g))
+        return false;
+    it->second(g, type1, type2, record);
+    return true;
+}
+
 
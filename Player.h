@@ -2,10 +2,13 @@
 #define PLAYER_INCLUDED
 
 #include <string>
+#include <vector>
 
 class Point;
 class Board;
 class Game;
+struct SalvoResult;
+struct GameRecord;
 
 class Player
 {
@@ -16,7 +19,7 @@ class Player
 
     virtual ~Player() {}
 
-    std::string name() const { return m_name; }
+    const std::string& name() const { return m_name; }
     const Game& game() const { return m_game; }
 
     virtual bool isHuman() const { return false; }
@@ -26,6 +29,13 @@ class Player
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                         bool shipDestroyed, int shipId) = 0;
     virtual void recordAttackByOpponent(Point p) = 0;
+      // For salvo games: fill points with the k shots to fire this turn and
+      // return how many were filled, then hear what they all did.  By
+      // default these are built from recommendAttack and recordAttackResult,
+      // and fewer than k are returned if no cell is left that isn't in the
+      // salvo already.
+    virtual int recommendAttacks(Point* points, int k);
+    virtual void recordAttackResults(const Point* points, int n, const SalvoResult& result);
       // We prevent any kind of Player object from being copied or assigned
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
@@ -33,8 +43,63 @@ class Player
   private:
     std::string m_name;
     const Game& m_game;
+
+    static bool inSalvo(const Point* points, int n, Point p);
 };
 
+  // type is one of playerTypes(), optionally followed by "+endgame" to
+  // have an endgame player with the default limits take over its targeting
 Player* createPlayer(std::string type, std::string nm, const Game& g);
 
+  // Every type createPlayer knows about
+std::vector<std::string> playerTypes();
+
+  // False for a type that can't play properly on g's board and ships:
+  // "optimal" when the board is too large for the solver
+bool playerTypeSuits(const std::string& type, const Game& g);
+
+  // Play one quiet game between computer player types type1 (moving first)
+  // and type2 through a game loop compiled for that pair of concrete types,
+  // so that none of its calls on the players is virtual.  Returns false
+  // without playing if the pairing isn't one of those compiled in (any two
+  // of "awful", "mediocre", "good", "optimal" and "density"), or if
+  // either type doesn't suit g; the caller can then fall back on
+  // createPlayer and Game::playQuietly.
+bool playKnownPairing(const std::string& type1, const std::string& type2, const Game& g,
+                      GameRecord& record);
+
+  // When an endgame player stops deferring to the player it wraps, and how
+  // much work it may do for one shot before deferring anyway
+struct EndgameParams
+{
+    double maxEstimate = 200000;     // take over once at most this many layouts may remain
+    long long maxLayouts = 1000000;  // give up enumerating past this many
+    long long maxMicros = 5000;      // or past this much time per shot
+};
+
+  // A player that plays like inner (which it takes ownership of) until few
+  // enough fleet layouts are consistent with its shots, then shoots at the
+  // cell the most of them cover
+Player* createEndgamePlayer(Player* inner, const Game& g, const EndgameParams& params);
+
+  // The knobs that shape a GoodPlayer's play.  The defaults are the values
+  // it has always used, except placementAttempts: ships used to be placed
+  // in at most 50 block-and-retry rounds, but a whole layout is now drawn
+  // at a time, and it takes far more draws to find a spaced one.
+struct GoodPlayerParams
+{
+    int placementAttempts = 1000000; // layouts drawn looking for one spaced apart
+    int shipSpacing = 4;        // no other ship within this many cells in a row or column
+    int parity = 0;             // hunt on cells whose r+c has this parity...
+    int parityRetries = 50;     // ...for this many random picks, then on the other
+    int alertRetries = 50;      // random picks near a hit before widening the search
+    int alertRadius = 1;        // starting distance searched around a hit
+    int alertGrowth = 1;        // how much that distance widens each time
+    int searchRetries = 30;     // random picks near a sunk ship before widening
+    int searchMaxRadius = 4;    // give up looking near a sunk ship at this distance
+};
+
+Player* createGoodPlayer(std::string nm, const Game& g,
+                         const GoodPlayerParams& params);
+
 #endif // PLAYER_INCLUDED
@@ -0,0 +1,285 @@
+#include "Replay.h"
+#include "Board.h"
+#include "Bitboard.h"
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    const unsigned char VERSION = 1;
+    const int OFFBOARD = 127;
+    const size_t GAMEHEADERSIZE = 13;  // seed, winner, number of shots
+
+    void putLittleEndian(unsigned char* p, uint64_t value, int nBytes)
+    {
+        for (int i = 0; i < nBytes; i++)
+            p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    uint64_t getLittleEndian(const unsigned char* p, int nBytes)
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < nBytes; i++)
+            value |= uint64_t(p[i]) << (8 * i);
+        return value;
+    }
+
+    void write(ofstream& out, uint64_t value, int nBytes)
+    {
+        unsigned char bytes[8];
+        putLittleEndian(bytes, value, nBytes);
+        out.write(reinterpret_cast<const char*>(bytes), nBytes);
+    }
+}
+
+//******************** ReplayWriter ********************************
+
+ReplayWriter::ReplayWriter()
+ : m_offset(0), m_nShips(0)
+{}
+
+ReplayWriter::~ReplayWriter()
+{
+    close();
+}
+
+bool ReplayWriter::open(const string& path, const Game& g)
+{
+    close();
+    m_out.open(path.c_str(), ios::binary | ios::trunc);
+    if (!m_out)
+        return false;
+    m_nShips = g.nShips();
+    m_index.clear();
+
+    //Header describing the board and fleet
+    m_out.write("BSRP", 4);
+    write(m_out, VERSION, 1);
+    write(m_out, g.rows(), 1);
+    write(m_out, g.cols(), 1);
+    write(m_out, g.nShips(), 1);
+    m_offset = 8;
+    for (int s = 0; s < g.nShips(); s++)
+    {
+        string name = g.shipName(s).substr(0, 255);
+        write(m_out, g.shipLength(s), 1);
+        write(m_out, static_cast<unsigned char>(g.shipSymbol(s)), 1);
+        write(m_out, name.size(), 1);
+        m_out.write(name.data(), name.size());
+        m_offset += 3 + name.size();
+    }
+    return bool(m_out);
+}
+
+void ReplayWriter::append(const unsigned char* game, size_t size)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_out.is_open())
+        return;
+    m_index.push_back(m_offset);
+    m_out.write(reinterpret_cast<const char*>(game), size);
+    m_offset += size;
+}
+
+bool ReplayWriter::close()
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_out.is_open())
+        return true;
+    //Footer: the index, then what's needed to find it from the end of the file
+    for (size_t i = 0; i < m_index.size(); i++)
+        write(m_out, m_index[i], 8);
+    write(m_out, m_index.size(), 8);
+    write(m_out, m_offset, 8);
+    m_out.write("BSRX", 4);
+    bool ok = bool(m_out);
+    m_out.close();
+    return ok;
+}
+
+//******************** ReplayRecorder ********************************
+
+ReplayRecorder::ReplayRecorder(ReplayWriter& writer)
+ : m_writer(writer), m_seed(0), m_nShots(0), m_placed(false)
+{}
+
+void ReplayRecorder::beginGame(unsigned long long seed)
+{
+    m_seed = seed;
+    m_nShots = 0;
+    m_placed = false;
+    m_buffer.clear();
+}
+
+void ReplayRecorder::shipsPlaced(const Board& b1, const Board& b2)
+{
+    //Leave room for the game header, which is filled in when the game ends
+    m_buffer.assign(GAMEHEADERSIZE, 0);
+    const Board* boards[2] = { &b1, &b2 };
+    for (int seat = 0; seat < 2; seat++)
+        for (int s = 0; s < m_writer.nShips(); s++)
+        {
+            Point topOrLeft;
+            Direction dir = HORIZONTAL;
+            boards[seat]->shipPlacement(s, topOrLeft, dir);
+            m_buffer.push_back(static_cast<unsigned char>(
+                              cellIndex(topOrLeft) | (dir == VERTICAL ? 0x80 : 0)));
+        }
+    m_placed = true;
+}
+
+void ReplayRecorder::shotFired(int seat, Point p, bool /* validShot */, bool /* shotHit */,
+                               bool /* shipDestroyed */, int /* shipId */)
+{
+    bool onBoard = p.r >= 0  &&  p.r < MAXROWS  &&  p.c >= 0  &&  p.c < MAXCOLS;
+    int cell = onBoard ? cellIndex(p) : OFFBOARD;
+    m_buffer.push_back(static_cast<unsigned char>(cell | (seat << 7)));
+    m_nShots++;
+}
+
+void ReplayRecorder::gameOver(int winner)
+{
+    if (!m_placed)
+        return;
+    putLittleEndian(&m_buffer[0], m_seed, 8);
+    m_buffer[8] = static_cast<unsigned char>(static_cast<signed char>(winner));
+    putLittleEndian(&m_buffer[9], m_nShots, 4);
+    m_writer.append(&m_buffer[0], m_buffer.size());
+    m_placed = false;
+}
+
+//******************** ReplayReader ********************************
+
+Point ReplayGame::shot(int shot) const
+{
+    int cell = m_shots[shot] & 0x7F;
+    return cell == OFFBOARD ? Point(-1, -1) : cellPoint(cell);
+}
+
+void ReplayGame::placement(int seat, int shipId, Point& topOrLeft, Direction& dir) const
+{
+    unsigned char b = m_placements[seat * m_nShips + shipId];
+    topOrLeft = cellPoint(b & 0x7F);
+    dir = (b & 0x80) ? VERTICAL : HORIZONTAL;
+}
+
+ReplayReader::ReplayReader()
+ : m_rows(0), m_cols(0), m_nGames(0), m_index(nullptr)
+{}
+
+bool ReplayReader::open(const string& path)
+{
+    m_nGames = 0;
+    m_shipLengths.clear();
+    m_shipSymbols.clear();
+    m_shipNames.clear();
+    if (!m_file.open(path))
+        return false;
+    const unsigned char* data = m_file.data();
+    size_t size = m_file.size();
+    if (size < 8 + 20  ||  memcmp(data, "BSRP", 4) != 0  ||  data[4] != VERSION  ||
+                                        memcmp(data + size - 4, "BSRX", 4) != 0)
+        return false;
+
+    m_rows = data[5];
+    m_cols = data[6];
+    int nShips = data[7];
+    if (m_rows < 1  ||  m_rows > MAXROWS  ||  m_cols < 1  ||  m_cols > MAXCOLS  ||
+                                                                nShips > MAXSHIPS)
+        return false;
+    size_t pos = 8;
+    for (int s = 0; s < nShips; s++)
+    {
+        if (pos + 3 > size  ||  pos + 3 + data[pos + 2] > size)
+            return false;
+        m_shipLengths.push_back(data[pos]);
+        m_shipSymbols.push_back(static_cast<char>(data[pos + 1]));
+        m_shipNames.push_back(string(reinterpret_cast<const char*>(data + pos + 3),
+                                     data[pos + 2]));
+        pos += 3 + data[pos + 2];
+    }
+
+    //Check the index against the file size without any sum that can overflow
+    uint64_t nGames = getLittleEndian(data + size - 20, 8);
+    uint64_t indexStart = getLittleEndian(data + size - 12, 8);
+    if (indexStart < pos  ||  indexStart > size - 20  ||
+                                        (size - 20 - indexStart) / 8 != nGames  ||
+                                        (size - 20 - indexStart) % 8 != 0)
+        return false;
+
+    //Every game, shots included, must lie between the header and the index
+    uint64_t fixedSize = GAMEHEADERSIZE + 2 * uint64_t(nShips);
+    for (uint64_t i = 0; i < nGames; i++)
+    {
+        uint64_t offset = getLittleEndian(data + indexStart + 8 * i, 8);
+        if (offset < pos  ||  offset > indexStart  ||  indexStart - offset < fixedSize  ||
+                indexStart - offset - fixedSize < getLittleEndian(data + offset + 9, 4))
+            return false;
+    }
+    m_index = data + indexStart;
+    m_nGames = (long long)nGames;
+    return true;
+}
+
+bool ReplayReader::setUpGame(Game& g) const
+{
+    for (int s = 0; s < nShips(); s++)
+        if (!g.addShip(m_shipLengths[s], m_shipSymbols[s], m_shipNames[s]))
+            return false;
+    return true;
+}
+
+ReplayGame ReplayReader::game(long long i) const
+{
+    if (i < 0  ||  i >= m_nGames)
+    {
+        ReplayGame none;
+        none.seed = 0;
+        none.winner = -1;
+        none.nShots = 0;
+        none.m_nShips = 0;
+        none.m_placements = nullptr;
+        none.m_shots = nullptr;
+        return none;
+    }
+    const unsigned char* p = m_file.data() + getLittleEndian(m_index + 8 * i, 8);
+    ReplayGame result;
+    result.seed = getLittleEndian(p, 8);
+    result.winner = static_cast<signed char>(p[8]);
+    result.nShots = int(getLittleEndian(p + 9, 4));
+    result.m_nShips = nShips();
+    result.m_placements = p + GAMEHEADERSIZE;
+    result.m_shots = result.m_placements + 2 * nShips();
+    return result;
+}
+
+int replayGame(const ReplayGame& game, Board& b1, Board& b2)
+{
+    Board* boards[2] = { &b1, &b2 };
+    for (int seat = 0; seat < 2; seat++)
+    {
+        boards[seat]->clear();
+        for (int s = 0; s < game.nShips(); s++)
+        {
+            Point topOrLeft;
+            Direction dir;
+            game.placement(seat, s, topOrLeft, dir);
+            if (!boards[seat]->placeShip(topOrLeft, s, dir))
+                return -1;
+        }
+    }
+
+    //Each seat's shots land on the other seat's board
+    bool shotHit, shipDestroyed;
+    int shipId;
+    for (int i = 0; i < game.nShots; i++)
+    {
+        int seat = game.seatOf(i);
+        Board& target = *boards[1 - seat];
+        target.attack(game.shot(i), shotHit, shipDestroyed, shipId);
+        if (target.allShipsDestroyed())
+            return seat;
+    }
+    return -1;
+}
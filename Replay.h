@@ -0,0 +1,123 @@
+#ifndef REPLAY_INCLUDED
+#define REPLAY_INCLUDED
+
+#include "Game.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+  // A replay file holds complete games: each game's seed, both fleets'
+  // layouts and every shot, one byte per shot.  Games are appended one
+  // after another and an index of where each starts is written at the end,
+  // so a reader can go straight to any game.  All numbers are little-endian.
+  //
+  //   header:  "BSRP", version, rows, cols, number of ships, then for each
+  //            ship its length, symbol, name length and name
+  //   game:    seed (8 bytes), winning seat (1, -1 if none), number of
+  //            shots (4), one placement byte per ship for seat 0 and then
+  //            seat 1 (top or left cell, plus 128 if vertical), then one
+  //            byte per shot (cell, plus 128 if seat 1 fired it; cell 127
+  //            stands for any shot off the board)
+  //   footer:  offset of each game (8 bytes each), number of games (8),
+  //            offset of the first of those index entries (8), "BSRX"
+
+class ReplayWriter
+{
+  public:
+    ReplayWriter();
+    ~ReplayWriter();
+    bool open(const std::string& path, const Game& g);
+    int nShips() const { return m_nShips; }
+      // Add one encoded game; safe to call from several threads
+    void append(const unsigned char* game, std::size_t size);
+      // Write the index; returns false if anything failed to be written
+    bool close();
+      // We prevent a ReplayWriter object from being copied or assigned
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+  private:
+    std::ofstream m_out;
+    std::mutex m_mutex;
+    std::vector<std::uint64_t> m_index;
+    std::uint64_t m_offset;
+    int m_nShips;
+};
+
+  // Observes a Game and appends each game it plays to a ReplayWriter.
+  // Call beginGame before each game so the seed gets recorded.
+class ReplayRecorder : public GameObserver
+{
+  public:
+    ReplayRecorder(ReplayWriter& writer);
+    void beginGame(unsigned long long seed);
+    virtual void shipsPlaced(const Board& b1, const Board& b2);
+    virtual void shotFired(int seat, Point p, bool validShot, bool shotHit,
+                           bool shipDestroyed, int shipId);
+    virtual void gameOver(int winner);
+
+  private:
+    ReplayWriter& m_writer;
+    std::vector<unsigned char> m_buffer;
+    unsigned long long m_seed;
+    std::uint32_t m_nShots;
+    bool m_placed;
+};
+
+  // One game inside a mapped replay file; it points into the file's memory
+  // rather than holding copies
+class ReplayGame
+{
+  public:
+    unsigned long long seed;
+    int winner;
+    int nShots;
+    int nShips() const { return m_nShips; }
+    int seatOf(int shot) const { return m_shots[shot] >> 7; }
+    Point shot(int shot) const;
+    void placement(int seat, int shipId, Point& topOrLeft, Direction& dir) const;
+
+  private:
+    friend class ReplayReader;
+    int m_nShips;
+    const unsigned char* m_placements;
+    const unsigned char* m_shots;
+};
+
+class ReplayReader
+{
+  public:
+    ReplayReader();
+    bool open(const std::string& path);
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int nShips() const { return int(m_shipLengths.size()); }
+      // Add the recorded fleet to g, which must have rows() rows and cols() columns
+    bool setUpGame(Game& g) const;
+    long long nGames() const { return m_nGames; }
+      // Game number i; every game's extent was checked against the file
+      // when it was opened.  For an i out of range, a game with no ships
+      // and no shots.
+    ReplayGame game(long long i) const;
+
+  private:
+    MappedFile m_file;
+    int m_rows;
+    int m_cols;
+    std::vector<int> m_shipLengths;
+    std::vector<char> m_shipSymbols;
+    std::vector<std::string> m_shipNames;
+    long long m_nGames;
+    const unsigned char* m_index;
+};
+
+  // Play a recorded game again through Board::attack, on boards belonging
+  // to a Game set up by setUpGame.  The boards are cleared first.  Returns
+  // the seat that won, or -1 if the replay didn't end in a win.
+int replayGame(const ReplayGame& game, Board& b1, Board& b2);
+
+#endif // REPLAY_INCLUDED
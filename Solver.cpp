@@ -0,0 +1,352 @@
+#include "Solver.h"
+#include "Game.h"
+#include <limits>
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+using namespace std;
+
+size_t OptimalSolver::StateHash::operator()(const State& s) const
+{
+    uint64_t h = s.hit.hash();
+    for (size_t w = 0; w < s.layouts.size(); w++)
+        h = (h ^ s.layouts[w]) * 0x100000001B3ULL;
+    return size_t(h ^ (h >> 32));
+}
+
+OptimalSolver::OptimalSolver(const Game& g, size_t maxLayouts, size_t maxStates,
+                             size_t maxTableBytes)
+ : m_rows(g.rows()), m_cols(g.cols()), m_maxLayouts(maxLayouts), m_maxStates(maxStates),
+   m_maxTableBytes(maxTableBytes), m_stateLimit(maxStates),
+   m_nShips(g.nShips()), m_nLayouts(0), m_symmetries(g.rows(), g.cols()),
+   m_solved(false), m_aborted(false)
+{
+    for (int s = 0; s < m_nShips; s++)
+        m_placements.push_back(shipPlacements(g, g.shipLength(s)));
+}
+
+bool OptimalSolver::solve()
+{
+    if (m_solved)
+        return true;
+    //Enumerate every layout of non-overlapping ships, giving up if there are too many
+    m_layouts.clear();
+    m_masks.clear();
+    m_nLayouts = 0;
+    vector<int> chosen;
+    if (m_nShips == 0  ||  !enumerate(0, Bitboard(), chosen)  ||  m_nLayouts == 0)
+    {
+        m_layouts.clear();
+        m_masks.clear();
+        m_nLayouts = 0;
+        m_layoutImages.clear();
+        return false;
+    }
+    findLayoutImages();
+
+    //A state costs its key's layout bits on top of the entry and the hash
+    //table's own bookkeeping, roughly a node and a bucket
+    size_t stateBytes = sizeof(State) + sizeof(Entry) + 4 * sizeof(void*) +
+                        (m_nLayouts + 63) / 64 * sizeof(uint64_t);
+    m_stateLimit = min(m_maxStates, m_maxTableBytes / stateBytes);
+
+    vector<int> all(m_nLayouts);
+    for (size_t l = 0; l < m_nLayouts; l++)
+        all[l] = int(l);
+    m_aborted = false;
+    solveState(Knowledge(m_nShips), all);
+    if (m_aborted)
+    {
+        m_table.clear();
+        return false;
+    }
+    m_solved = true;
+    return true;
+}
+
+double OptimalSolver::expectedShots() const
+{
+    vector<int> all(m_nLayouts);
+    for (size_t l = 0; l < m_nLayouts; l++)
+        all[l] = int(l);
+    Symmetry symmetry;
+    unordered_map<State, Entry, StateHash>::const_iterator it =
+                                m_table.find(canonicalState(all, Bitboard(), symmetry));
+    return it == m_table.end() ? -1 : it->second.expected;
+}
+
+int OptimalSolver::bestShot(const Knowledge& k) const
+{
+    //Find the layouts that could have produced what k records
+    vector<int> layouts;
+    for (size_t l = 0; l < m_nLayouts; l++)
+        if (k.consistentWith(&m_masks[l * m_nShips]))
+            layouts.push_back(int(l));
+    Symmetry symmetry;
+    unordered_map<State, Entry, StateHash>::const_iterator it =
+                                m_table.find(canonicalState(layouts, k.hit, symmetry));
+    if (it == m_table.end()  ||  it->second.cell < 0)
+        return -1;
+    //The table holds the best cell of the stored copy; turn it back
+    return m_symmetries.transformCell(inverseSymmetry(symmetry), it->second.cell);
+}
+
+const Placement& OptimalSolver::placement(size_t layoutId, int shipId) const
+{
+    return m_placements[shipId][m_layouts[layoutId * m_nShips + shipId]];
+}
+
+//Place ships shipId onwards in every possible way; false if the limit was exceeded
+bool OptimalSolver::enumerate(int shipId, Bitboard occupied, vector<int>& chosen)
+{
+    if (shipId == m_nShips)
+    {
+        if (m_nLayouts == m_maxLayouts)
+            return false;
+        for (int s = 0; s < m_nShips; s++)
+        {
+            m_layouts.push_back(chosen[s]);
+            m_masks.push_back(m_placements[s][chosen[s]].mask);
+        }
+        m_nLayouts++;
+        return true;
+    }
+    for (size_t i = 0; i < m_placements[shipId].size(); i++)
+    {
+        const Bitboard& mask = m_placements[shipId][i].mask;
+        if (mask.intersects(occupied))
+            continue;
+        chosen.push_back(int(i));
+        bool ok = enumerate(shipId + 1, occupied | mask, chosen);
+        chosen.pop_back();
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+OptimalSolver::State OptimalSolver::makeState(const vector<int>& layouts,
+                                              const Bitboard& hit) const
+{
+    State state;
+    state.layouts.assign((m_nLayouts + 63) / 64, 0);
+    for (size_t i = 0; i < layouts.size(); i++)
+        state.layouts[layouts[i] / 64] |= uint64_t(1) << (layouts[i] % 64);
+    state.hit = hit;
+    return state;
+}
+
+//Work out where each symmetry of the board takes each layout.  A ship's
+//placements turn into placements of the same ship, so on a board the ships
+//fit on every way round, every layout turns into another.
+void OptimalSolver::findLayoutImages()
+{
+    m_layoutImages.assign(m_symmetries.count(), vector<int>());
+    for (int s = 1; s < m_symmetries.count(); s++)
+    {
+        vector< vector<int> > placementImages(m_nShips);
+        bool ok = true;
+        for (int ship = 0; ok  &&  ship < m_nShips; ship++)
+            for (size_t i = 0; ok  &&  i < m_placements[ship].size(); i++)
+            {
+                Bitboard image = m_symmetries.transform(Symmetry(s), m_placements[ship][i].mask);
+                int found = -1;
+                for (size_t j = 0; found < 0  &&  j < m_placements[ship].size(); j++)
+                    if (m_placements[ship][j].mask == image)
+                        found = int(j);
+                placementImages[ship].push_back(found);
+                ok = (found >= 0);
+            }
+
+        vector<int>& images = m_layoutImages[s];
+        vector<int> chosen(m_nShips);
+        for (size_t l = 0; ok  &&  l < m_nLayouts; l++)
+        {
+            for (int ship = 0; ship < m_nShips; ship++)
+                chosen[ship] = placementImages[ship][m_layouts[l * m_nShips + ship]];
+            images.push_back(findLayout(chosen));
+            ok = (images.back() >= 0);
+        }
+        if (!ok)
+            images.clear();
+    }
+}
+
+//The id of the layout with these placement indices, or -1 if there's none.
+//enumerate produced the layouts in lexicographic order of their indices.
+int OptimalSolver::findLayout(const vector<int>& chosen) const
+{
+    size_t lo = 0;
+    size_t hi = m_nLayouts;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        const int* layout = &m_layouts[mid * m_nShips];
+        if (lexicographical_compare(layout, layout + m_nShips, chosen.begin(), chosen.end()))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < m_nLayouts  &&  equal(chosen.begin(), chosen.end(), &m_layouts[lo * m_nShips]))
+        return int(lo);
+    return -1;
+}
+
+OptimalSolver::State OptimalSolver::canonicalState(const vector<int>& layouts,
+                                                   const Bitboard& hit, Symmetry& symmetry) const
+{
+    State best = makeState(layouts, hit);
+    symmetry = SYM_IDENTITY;
+    vector<int> images(layouts.size());
+    for (size_t s = 1; s < m_layoutImages.size(); s++)
+    {
+        if (m_layoutImages[s].empty())
+            continue;
+        //Most copies lose on the hits alone, so don't build the rest of them
+        Bitboard imageHit = m_symmetries.transform(Symmetry(s), hit);
+        if (best.hit < imageHit)
+            continue;
+        for (size_t i = 0; i < layouts.size(); i++)
+            images[i] = m_layoutImages[s][layouts[i]];
+        State copy = makeState(images, imageHit);
+        if (copy < best)
+        {
+            best = copy;
+            symmetry = Symmetry(s);
+        }
+    }
+    return best;
+}
+
+Bitboard OptimalSolver::occupied(int layoutId) const
+{
+    Bitboard result;
+    for (int s = 0; s < m_nShips; s++)
+        result |= m_masks[layoutId * m_nShips + s];
+    return result;
+}
+
+//Expected number of shots still needed to win from state k, where layouts
+//holds the layouts consistent with k
+double OptimalSolver::solveState(const Knowledge& k, const vector<int>& layouts)
+{
+    if (k.allSunk())
+        return 0;
+    Symmetry symmetry;
+    State state = canonicalState(layouts, k.hit, symmetry);
+    unordered_map<State, Entry, StateHash>::const_iterator found = m_table.find(state);
+    if (found != m_table.end())
+        return found->second.expected;
+    if (m_aborted  ||  m_table.size() >= m_stateLimit)
+    {
+        m_aborted = true;
+        return 0;
+    }
+
+    //Count how many of the remaining layouts put a ship on each unshot cell
+    Bitboard unshot = Bitboard::area(m_rows, m_cols) & ~k.shot;
+    int occupancy[MAXCELLS] = {};
+    vector<int> unshotShipCells(layouts.size());
+    for (size_t i = 0; i < layouts.size(); i++)
+    {
+        Bitboard cells = occupied(layouts[i]) & unshot;
+        unshotShipCells[i] = cells.count();
+        while (cells.any())
+            occupancy[cells.popLowest()]++;
+    }
+
+    //Try the most likely cells first, so the bound below prunes more
+    vector<int> candidates;
+    for (Bitboard cells = unshot; cells.any(); )
+    {
+        int cell = cells.popLowest();
+        //A certain miss costs a shot and teaches nothing
+        if (occupancy[cell] > 0)
+            candidates.push_back(cell);
+    }
+    stable_sort(candidates.begin(), candidates.end(),
+                [&occupancy](int a, int b) { return occupancy[a] > occupancy[b]; });
+
+    //Outcome 0 is a miss, 1 a hit, and 2+s the destruction of ship s
+    Entry best = { numeric_limits<double>::infinity(), -1 };
+    vector< vector<int> > outcomes(m_nShips + 2);
+    vector<double> lowerBound(m_nShips + 2);
+    for (size_t ci = 0; ci < candidates.size(); ci++)
+    {
+        int cell = candidates[ci];
+        for (size_t o = 0; o < outcomes.size(); o++)
+        {
+            outcomes[o].clear();
+            lowerBound[o] = 0;
+        }
+        Bitboard target = Bitboard::cell(cell);
+        for (size_t i = 0; i < layouts.size(); i++)
+        {
+            int outcome = 0;
+            for (int s = 0; s < m_nShips; s++)
+            {
+                const Bitboard& mask = m_masks[layouts[i] * m_nShips + s];
+                if (mask.test(cell))
+                {
+                    outcome = (k.hit | target).contains(mask) ? 2 + s : 1;
+                    break;
+                }
+            }
+            outcomes[outcome].push_back(layouts[i]);
+            //Every ship cell not yet shot will cost at least one more shot
+            lowerBound[outcome] += unshotShipCells[i] - (outcome > 0 ? 1 : 0);
+        }
+
+        //Start from the bound and replace it outcome by outcome with the
+        //exact value, abandoning the cell once it can't beat the best so far
+        double expected = 1;
+        for (size_t o = 0; o < outcomes.size(); o++)
+            expected += lowerBound[o] / layouts.size();
+        for (size_t o = 0; o < outcomes.size()  &&  expected < best.expected - 1e-12; o++)
+        {
+            if (outcomes[o].empty())
+                continue;
+            Knowledge next = k;
+            next.shot.set(cell);
+            if (o >= 1)
+                next.hit.set(cell);
+            if (o >= 2)
+                next.sunkAt[o - 2] = static_cast<signed char>(cell);
+            expected += (outcomes[o].size() * solveState(next, outcomes[o]) -
+                                                    lowerBound[o]) / layouts.size();
+        }
+        if (expected < best.expected - 1e-12)
+        {
+            best.expected = expected;
+            best.cell = cell;
+        }
+    }
+    double expected = best.expected;
+    if (best.cell >= 0)
+        best.cell = m_symmetries.transformCell(symmetry, best.cell);
+    m_table[state] = best;
+    return expected;
+}
+
+shared_ptr<const OptimalSolver> sharedOptimalSolver(const Game& g)
+{
+    //The solution depends only on the board size and the ship lengths.
+    //Solving holds the lock, so no board is ever solved twice.
+    static mutex cacheMutex;
+    static map<vector<int>, shared_ptr<const OptimalSolver> > cache;
+    vector<int> key;
+    key.push_back(g.rows());
+    key.push_back(g.cols());
+    for (int s = 0; s < g.nShips(); s++)
+        key.push_back(g.shipLength(s));
+    lock_guard<mutex> lock(cacheMutex);
+    shared_ptr<const OptimalSolver>& cached = cache[key];
+    if (cached == nullptr)
+    {
+        shared_ptr<OptimalSolver> solver = make_shared<OptimalSolver>(g);
+        solver->solve();
+        cached = solver;
+    }
+    return cached;
+}
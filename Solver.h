@@ -0,0 +1,105 @@
+#ifndef SOLVER_INCLUDED
+#define SOLVER_INCLUDED
+
+#include "Fleet.h"
+#include "Symmetry.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+class Game;
+
+  // Exhaustive solver for tiny boards.  It enumerates every fleet layout,
+  // assumes the opponent picked one uniformly at random, and computes for
+  // every knowledge state reachable by shooting the shot that minimizes the
+  // expected number of shots still needed to win.  The resulting table is
+  // what OptimalPlayer plays from.
+  //
+  // A state is memoized by the set of layouts still consistent with what's
+  // known plus the cells hit so far; that's all the future depends on, and
+  // it merges states that differ only by misses in cells no remaining
+  // layout uses.  States that are turned or flipped copies of each other
+  // are solved once and share one entry, stored under whichever copy is
+  // lowest, which cuts the table by up to the board's number of symmetries.
+class OptimalSolver
+{
+  public:
+      // Each state's key holds a bit per layout, so besides the number of
+      // states the table is held to about maxTableBytes of memory
+    OptimalSolver(const Game& g, std::size_t maxLayouts = 100000,
+                  std::size_t maxStates = 2000000,
+                  std::size_t maxTableBytes = std::size_t(256) << 20);
+      // Returns false if the board has too many layouts or states to solve
+    bool solve();
+    bool solved() const { return m_solved; }
+    double expectedShots() const;
+    std::size_t nLayouts() const { return m_nLayouts; }
+    std::size_t nStates() const { return m_table.size(); }
+      // Best cell to shoot in state k, or -1 if k is not in the table
+    int bestShot(const Knowledge& k) const;
+      // Where ship shipId lies in layout number layoutId
+    const Placement& placement(std::size_t layoutId, int shipId) const;
+
+  private:
+    struct Entry
+    {
+        double expected;
+        int cell;
+    };
+    struct State
+    {
+        std::vector<std::uint64_t> layouts;  // one bit per layout id
+        Bitboard hit;
+        friend bool operator==(const State& a, const State& b)
+        {
+            return a.hit == b.hit  &&  a.layouts == b.layouts;
+        }
+        friend bool operator<(const State& a, const State& b)
+        {
+            return a.hit != b.hit ? a.hit < b.hit : a.layouts < b.layouts;
+        }
+    };
+    struct StateHash
+    {
+        std::size_t operator()(const State& s) const;
+    };
+    int m_rows;
+    int m_cols;
+    std::size_t m_maxLayouts;
+    std::size_t m_maxStates;
+    std::size_t m_maxTableBytes;
+    std::size_t m_stateLimit;          // m_maxStates, or fewer if states are big
+    int m_nShips;
+    std::vector<std::vector<Placement> > m_placements;  // per ship
+    std::vector<int> m_layouts;        // m_nShips placement indices per layout
+    std::vector<Bitboard> m_masks;     // m_nShips placement masks per layout
+    std::size_t m_nLayouts;
+    BoardSymmetries m_symmetries;
+      // Per symmetry, the id of the layout each layout id turns into; empty
+      // for a symmetry the layouts can't follow
+    std::vector<std::vector<int> > m_layoutImages;
+    std::unordered_map<State, Entry, StateHash> m_table;
+    bool m_solved;
+    bool m_aborted;
+
+    bool enumerate(int shipId, Bitboard occupied, std::vector<int>& chosen);
+    State makeState(const std::vector<int>& layouts, const Bitboard& hit) const;
+    void findLayoutImages();
+    int findLayout(const std::vector<int>& chosen) const;
+      // The copy of a state the table stores it under, setting symmetry to
+      // the symmetry that takes the state to it
+    State canonicalState(const std::vector<int>& layouts, const Bitboard& hit,
+                         Symmetry& symmetry) const;
+    Bitboard occupied(int layoutId) const;
+    double solveState(const Knowledge& k, const std::vector<int>& layouts);
+};
+
+  // A solver for g's board and ships, solved (or found too large to solve)
+  // the first time any caller asks for that board size and those ship
+  // lengths, and shared with every caller after that.  Safe to call from
+  // several threads at once.
+std::shared_ptr<const OptimalSolver> sharedOptimalSolver(const Game& g);
+
+#endif // SOLVER_INCLUDED
@@ -0,0 +1,282 @@
+#include "Spectator.h"
+#include "Board.h"
+#include "Fleet.h"
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_SHM
+#endif
+
+using namespace std;
+
+//The feed is an array of 64-bit words: a header of HEADERWORDS words, then
+//one slot of SLOTWORDS words per event.  Each slot is one cache line: its
+//sequence word, the game id, the shot number, type, seat, cell and result
+//flags packed into one word, the two bitboards, and the ship id.
+static const uint64_t MAGIC = 0x3146535342ULL;  // "BSSF1"
+static const size_t HEADERWORDS = 8;             // magic, capacity, write index
+static const size_t SLOTWORDS = 8;
+static const size_t WRITEINDEX = 2;
+
+SpectatorFeed::SpectatorFeed()
+ : m_words(nullptr), m_capacity(0), m_bytes(0), m_owner(false)
+{}
+
+SpectatorFeed::~SpectatorFeed()
+{
+    close();
+}
+
+bool SpectatorFeed::create(const string& name, size_t capacity)
+{
+    close();
+    if (capacity == 0)
+        return false;
+    m_bytes = (HEADERWORDS + capacity * SLOTWORDS) * sizeof(uint64_t);
+    void* p = nullptr;
+#ifdef HAVE_SHM
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, off_t(m_bytes)) != 0)
+    {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    p = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return false;
+    }
+#else
+    p = ::operator new(m_bytes);
+#endif
+    //Every word starts out zero, so no slot looks like it holds an event
+    size_t nWords = m_bytes / sizeof(uint64_t);
+    m_words = static_cast<atomic<uint64_t>*>(p);
+    for (size_t w = 0; w < nWords; w++)
+        new (&m_words[w]) atomic<uint64_t>(0);
+    m_words[1].store(capacity, memory_order_relaxed);
+    m_words[0].store(MAGIC, memory_order_release);
+    m_capacity = capacity;
+    m_name = name;
+    m_owner = true;
+    return true;
+}
+
+bool SpectatorFeed::attach(const string& name)
+{
+    close();
+#ifdef HAVE_SHM
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0  ||  size_t(info.st_size) < HEADERWORDS * sizeof(uint64_t))
+    {
+        ::close(fd);
+        return false;
+    }
+    m_bytes = size_t(info.st_size);
+    void* p = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return false;
+    m_words = static_cast<atomic<uint64_t>*>(p);
+    m_capacity = size_t(m_words[1].load(memory_order_relaxed));
+    if (m_words[0].load(memory_order_acquire) != MAGIC  ||
+        (HEADERWORDS + m_capacity * SLOTWORDS) * sizeof(uint64_t) > m_bytes)
+    {
+        close();
+        return false;
+    }
+    m_name = name;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SpectatorFeed::close()
+{
+    if (m_words == nullptr)
+        return;
+#ifdef HAVE_SHM
+    munmap(m_words, m_bytes);
+    if (m_owner)
+        shm_unlink(m_name.c_str());
+#else
+    ::operator delete(m_words);
+#endif
+    m_words = nullptr;
+    m_capacity = 0;
+    m_bytes = 0;
+    m_owner = false;
+}
+
+atomic<uint64_t>* SpectatorFeed::slot(uint64_t index) const
+{
+    return m_words + HEADERWORDS + (index % m_capacity) * SLOTWORDS;
+}
+
+void SpectatorFeed::publish(const SpectatorEvent& event)
+{
+    if (m_words == nullptr)
+        return;
+    uint64_t index = m_words[WRITEINDEX].fetch_add(1, memory_order_relaxed);
+    atomic<uint64_t>* s = slot(index);
+
+    //Claim the slot by turning its even stamp odd, so that it's never
+    //written by two threads at once.  If another writer holds it, or it
+    //already holds a later event, this event is dropped; readers then see
+    //it as lost.  Readers that see the odd stamp, or see it change, drop
+    //the event too.
+    uint64_t stamp = s[0].load(memory_order_relaxed);
+    do
+    {
+        if (stamp % 2 != 0  ||  stamp > 2 * index + 1)
+            return;
+    } while (!s[0].compare_exchange_weak(stamp, 2 * index + 1, memory_order_relaxed));
+    atomic_thread_fence(memory_order_release);
+    uint64_t info = uint64_t(uint32_t(event.shotNumber)) |
+                    uint64_t(uint8_t(event.type)) << 32 |
+                    uint64_t(uint8_t(event.seat)) << 40 |
+                    uint64_t(uint8_t(event.cell)) << 48 |
+                    uint64_t((event.validShot ? 1 : 0) | (event.shotHit ? 2 : 0) |
+                             (event.shipDestroyed ? 4 : 0)) << 56;
+    s[1].store(event.gameId, memory_order_relaxed);
+    s[2].store(info, memory_order_relaxed);
+    s[3].store(event.first.lo(), memory_order_relaxed);
+    s[4].store(event.first.hi(), memory_order_relaxed);
+    s[5].store(event.second.lo(), memory_order_relaxed);
+    s[6].store(event.second.hi(), memory_order_relaxed);
+    s[7].store(uint64_t(int64_t(event.shipId)), memory_order_relaxed);
+    s[0].store(2 * index + 2, memory_order_release);
+}
+
+uint64_t SpectatorFeed::published() const
+{
+    return m_words == nullptr ? 0 : m_words[WRITEINDEX].load(memory_order_acquire);
+}
+
+bool SpectatorFeed::read(uint64_t index, SpectatorEvent& event) const
+{
+    if (m_words == nullptr)
+        return false;
+    const atomic<uint64_t>* s = slot(index);
+    uint64_t before = s[0].load(memory_order_acquire);
+    if (before != 2 * index + 2)
+        return false;
+    uint64_t gameId = s[1].load(memory_order_relaxed);
+    uint64_t info = s[2].load(memory_order_relaxed);
+    uint64_t w3 = s[3].load(memory_order_relaxed);
+    uint64_t w4 = s[4].load(memory_order_relaxed);
+    uint64_t w5 = s[5].load(memory_order_relaxed);
+    uint64_t w6 = s[6].load(memory_order_relaxed);
+    uint64_t w7 = s[7].load(memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (s[0].load(memory_order_relaxed) != before)
+        return false;
+
+    event.gameId = gameId;
+    event.shotNumber = int(uint32_t(info));
+    event.type = SpectatorEvent::Type(uint8_t(info >> 32));
+    event.seat = int(int8_t(uint8_t(info >> 40)));
+    event.cell = int(int8_t(uint8_t(info >> 48)));
+    event.validShot = (info >> 56 & 1) != 0;
+    event.shotHit = (info >> 57 & 1) != 0;
+    event.shipDestroyed = (info >> 58 & 1) != 0;
+    event.shipId = int(int64_t(w7));
+    event.first = Bitboard(w3, w4);
+    event.second = Bitboard(w5, w6);
+    return true;
+}
+
+//******************** SpectatorRecorder ********************************
+
+SpectatorRecorder::SpectatorRecorder(SpectatorFeed& feed, const Game& g)
+ : m_feed(feed), m_fleet(g.catalog()), m_gameId(0), m_nShots(0)
+{}
+
+void SpectatorRecorder::beginGame(uint64_t gameId)
+{
+    m_gameId = gameId;
+    m_nShots = 0;
+    for (int seat = 0; seat < 2; seat++)
+        m_shot[seat] = m_hit[seat] = Bitboard();
+}
+
+void SpectatorRecorder::shipsPlaced(const Board& b1, const Board& b2)
+{
+    SpectatorEvent event = SpectatorEvent();
+    event.type = SpectatorEvent::PLACED;
+    event.gameId = m_gameId;
+    event.seat = -1;
+    event.cell = -1;
+    event.shipId = -1;
+    const Board* boards[2] = { &b1, &b2 };
+    Bitboard ships[2];
+    for (int seat = 0; seat < 2; seat++)
+        for (int s = 0; s < m_fleet->nShips(); s++)
+        {
+            Point topOrLeft;
+            Direction dir;
+            if (!boards[seat]->shipPlacement(s, topOrLeft, dir))
+                continue;
+            int i = m_fleet->placementIndex(s, topOrLeft, dir);
+            if (i >= 0)
+                ships[seat] |= m_fleet->placements(s)[i].mask;
+        }
+    event.first = ships[0];
+    event.second = ships[1];
+    m_feed.publish(event);
+}
+
+void SpectatorRecorder::shotFired(int seat, Point p, bool validShot, bool shotHit,
+                                  bool shipDestroyed, int shipId)
+{
+    //Seat fires at the other seat's board
+    int target = 1 - seat;
+    bool onBoard = p.r >= 0  &&  p.r < MAXROWS  &&  p.c >= 0  &&  p.c < MAXCOLS;
+    if (validShot  &&  onBoard)
+    {
+        m_shot[target].set(cellIndex(p));
+        if (shotHit)
+            m_hit[target].set(cellIndex(p));
+    }
+    m_nShots++;
+
+    SpectatorEvent event;
+    event.type = SpectatorEvent::SHOT;
+    event.gameId = m_gameId;
+    event.shotNumber = m_nShots;
+    event.seat = seat;
+    event.cell = onBoard ? cellIndex(p) : -1;
+    event.validShot = validShot;
+    event.shotHit = shotHit;
+    event.shipDestroyed = shipDestroyed;
+    event.shipId = shipDestroyed ? shipId : -1;
+    event.first = m_shot[target];
+    event.second = m_hit[target];
+    m_feed.publish(event);
+}
+
+void SpectatorRecorder::gameOver(int winner)
+{
+    SpectatorEvent event = SpectatorEvent();
+    event.type = SpectatorEvent::OVER;
+    event.gameId = m_gameId;
+    event.shotNumber = m_nShots;
+    event.seat = winner;
+    event.cell = -1;
+    event.shipId = -1;
+    m_feed.publish(event);
+}
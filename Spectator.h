@@ -0,0 +1,101 @@
+#ifndef SPECTATOR_INCLUDED
+#define SPECTATOR_INCLUDED
+
+#include "Game.h"
+#include "Bitboard.h"
+#include <memory>
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+class FleetCatalog;
+
+  // One thing that happened in a game being watched
+struct SpectatorEvent
+{
+    enum Type { PLACED, SHOT, OVER };
+    Type type;
+    std::uint64_t gameId;
+    int shotNumber;      // shots fired in the game so far, this one included
+    int seat;            // who fired (SHOT) or won, -1 for no one (OVER)
+    int cell;            // where the shot went, or -1 if off the board
+    bool validShot;
+    bool shotHit;
+    bool shipDestroyed;
+    int shipId;
+      // For SHOT, the cells of the target board shot at so far and those
+      // that hit; for PLACED, the cells of seat 0's and seat 1's ships
+    Bitboard first;
+    Bitboard second;
+};
+
+  // A ring of event slots in shared memory that game threads publish into
+  // and any number of readers, in this or other processes on the same
+  // host, watch.  Each slot is guarded by a sequence lock: the writer
+  // claims it by swapping its even stamp for an odd one, and stamps it even
+  // again, with the event's index, when it's done.  Publishing never waits
+  // for anything: a writer that finds its slot claimed by another writer a
+  // lap ahead or behind, or already holding a later event, drops its event.
+  // A reader that gets lapped, catches a slot mid-write or looks for a
+  // dropped event just sees that event as lost.  Readers see the ring in
+  // place, without it being copied.  Events are numbered from 0 in the
+  // order their slots were claimed.
+  //
+  // Where POSIX shared memory isn't available the ring lives in ordinary
+  // memory and can only be watched from inside the process.
+class SpectatorFeed
+{
+  public:
+    SpectatorFeed();
+    ~SpectatorFeed();
+      // Create the named feed (e.g. "/battleship") with room for capacity
+      // events, replacing any feed of that name
+    bool create(const std::string& name, std::size_t capacity = 4096);
+      // Attach to a feed another process created, for reading
+    bool attach(const std::string& name);
+    void close();
+      // Safe to call from any number of threads at once
+    void publish(const SpectatorEvent& event);
+      // How many events have been published so far
+    std::uint64_t published() const;
+      // Event number index, if it's still in the ring and not being
+      // overwritten right now
+    bool read(std::uint64_t index, SpectatorEvent& event) const;
+    std::size_t capacity() const { return m_capacity; }
+      // We prevent a SpectatorFeed object from being copied or assigned
+    SpectatorFeed(const SpectatorFeed&) = delete;
+    SpectatorFeed& operator=(const SpectatorFeed&) = delete;
+
+  private:
+    std::atomic<std::uint64_t>* m_words;  // header, then the slots
+    std::size_t m_capacity;
+    std::size_t m_bytes;
+    std::string m_name;
+    bool m_owner;
+
+    std::atomic<std::uint64_t>* slot(std::uint64_t index) const;
+};
+
+  // Observes a Game and publishes what happens in each game it plays to a
+  // feed.  Call beginGame before each game to give it an id.
+class SpectatorRecorder : public GameObserver
+{
+  public:
+    SpectatorRecorder(SpectatorFeed& feed, const Game& g);
+    void beginGame(std::uint64_t gameId);
+    virtual void shipsPlaced(const Board& b1, const Board& b2);
+    virtual void shotFired(int seat, Point p, bool validShot, bool shotHit,
+                           bool shipDestroyed, int shipId);
+    virtual void gameOver(int winner);
+
+  private:
+    SpectatorFeed& m_feed;
+    std::shared_ptr<const FleetCatalog> m_fleet;
+    std::uint64_t m_gameId;
+    int m_nShots;
+    Bitboard m_shot[2];   // per target seat
+    Bitboard m_hit[2];
+};
+
+#endif // SPECTATOR_INCLUDED
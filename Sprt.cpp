@@ -0,0 +1,67 @@
+#include "Sprt.h"
+#include "Game.h"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+Sprt::Sprt(double p0, double p1, double alpha, double beta)
+ : m_llr(0), m_wins(0), m_losses(0)
+{
+    m_winStep = log(p1 / p0);
+    m_lossStep = log((1 - p1) / (1 - p0));
+    m_lower = log(beta / (1 - alpha));
+    m_upper = log((1 - beta) / alpha);
+}
+
+void Sprt::addGame(bool aWon)
+{
+    if (aWon)
+    {
+        m_wins++;
+        m_llr += m_winStep;
+    }
+    else
+    {
+        m_losses++;
+        m_llr += m_lossStep;
+    }
+}
+
+Sprt::Decision Sprt::decision() const
+{
+    if (m_llr >= m_upper)
+        return A_STRONGER;
+    if (m_llr <= m_lower)
+        return A_WEAKER;
+    return UNDECIDED;
+}
+
+SprtResult runSprt(const SprtOptions& options)
+{
+    Sprt test(options.p0, options.p1, options.alpha, options.beta);
+    SprtResult result;
+    result.gamesUsed = 0;
+
+    MatchOptions match = options.match;
+    match.fleet = matchFleet(options.match);
+    typedef pair<GameRecord, int> Played;  // the record and the seat A sat in
+    parallelInOrder<Played>(match.nGames, match.nThreads,
+        [&](long long k) {
+            Played played;
+            played.second = playMatchGame(match, k, played.first);
+            return played;
+        },
+        [&](long long, const Played& played) {
+            const GameRecord& r = played.first;
+            result.stats.add(r, played.second);
+            if (r.winner >= 0)
+                test.addGame(r.winner == played.second);
+            result.gamesUsed++;
+            return test.decision() == Sprt::UNDECIDED;
+        });
+
+    result.decision = test.decision();
+    result.llr = test.llr();
+    return result;
+}
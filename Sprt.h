@@ -0,0 +1,56 @@
+#ifndef SPRT_INCLUDED
+#define SPRT_INCLUDED
+
+#include "Tournament.h"
+
+  // A sequential probability ratio test of player A's win probability p:
+  // H0 is p = p0 (A is weaker) against H1 is p = p1 (A is stronger).
+  // Games that neither player wins don't count.
+class Sprt
+{
+  public:
+    enum Decision { UNDECIDED, A_WEAKER, A_STRONGER };
+
+    Sprt(double p0, double p1, double alpha, double beta);
+    void addGame(bool aWon);
+    double llr() const { return m_llr; }
+    double lowerBound() const { return m_lower; }
+    double upperBound() const { return m_upper; }
+    Decision decision() const;
+    long long wins() const { return m_wins; }
+    long long losses() const { return m_losses; }
+
+  private:
+    double m_winStep;
+    double m_lossStep;
+    double m_lower;
+    double m_upper;
+    double m_llr;
+    long long m_wins;
+    long long m_losses;
+};
+
+struct SprtOptions
+{
+    MatchOptions match;     // match.nGames caps the number of games played
+    double p0 = 0.45;
+    double p1 = 0.55;
+    double alpha = 0.05;    // chance of calling A stronger when p = p0
+    double beta = 0.05;     // chance of calling A weaker when p = p1
+};
+
+struct SprtResult
+{
+    Sprt::Decision decision;
+    long long gamesUsed;    // games that went into the decision
+    double llr;
+    MatchStats stats;       // statistics of exactly those games
+};
+
+  // Keep playing the match, in parallel, until the test decides or the cap
+  // is reached.  Results are applied in game order, so the outcome doesn't
+  // depend on the number of threads; games still in flight when the test
+  // decides are discarded.
+SprtResult runSprt(const SprtOptions& options);
+
+#endif // SPRT_INCLUDED
@@ -0,0 +1,246 @@
+#include "Stats.h"
+#include "Game.h"
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+MatchStats::MatchStats()
+ : m_games(0), m_firstMoverWins(0), m_timeouts(0)
+{
+    for (int p = 0; p < 2; p++)
+    {
+        m_wins[p] = 0;
+        m_shots[p] = 0;
+        m_hits[p] = 0;
+        m_wasted[p] = 0;
+        m_maxMoveMicros[p] = 0;
+        m_slowMoves[p] = 0;
+        m_forfeits[p] = 0;
+        for (int b = 0; b <= MAXSHOTBUCKET; b++)
+            m_shotsToWin[p][b] = 0;
+        for (int s = 0; s < MAXSHIPS; s++)
+        {
+            m_sunk[p][s] = 0;
+            m_sinkTurnTotal[p][s] = 0;
+        }
+    }
+}
+
+void MatchStats::add(const GameRecord& record, int seatOfA)
+{
+    m_games++;
+    for (int p = 0; p < 2; p++)
+    {
+        //Player A sits in seatOfA, player B in the other seat
+        int seat = (p == 0 ? seatOfA : 1 - seatOfA);
+        m_shots[p] += record.shots[seat];
+        m_hits[p] += record.hits[seat];
+        m_wasted[p] += record.wasted[seat];
+        if (record.maxMoveMicros[seat] > m_maxMoveMicros[p])
+            m_maxMoveMicros[p] = record.maxMoveMicros[seat];
+        m_slowMoves[p] += record.slowMoves[seat];
+        for (int s = 0; s < MAXSHIPS; s++)
+            if (record.sinkTurn[seat][s] >= 0)
+            {
+                m_sunk[p][s]++;
+                m_sinkTurnTotal[p][s] += record.sinkTurn[seat][s];
+            }
+        if (record.outcome == GameRecord::FORFEIT  &&  record.winner == 1 - seat)
+            m_forfeits[p]++;
+        if (record.winner == seat)
+        {
+            m_wins[p]++;
+            int shots = record.shots[seat];
+            m_shotsToWin[p][shots < MAXSHOTBUCKET ? shots : MAXSHOTBUCKET]++;
+        }
+    }
+    if (record.winner == 0)
+        m_firstMoverWins++;
+    if (record.outcome == GameRecord::TIMEOUT)
+        m_timeouts++;
+}
+
+void MatchStats::merge(const MatchStats& other)
+{
+    m_games += other.m_games;
+    m_firstMoverWins += other.m_firstMoverWins;
+    m_timeouts += other.m_timeouts;
+    for (int p = 0; p < 2; p++)
+    {
+        m_wins[p] += other.m_wins[p];
+        m_shots[p] += other.m_shots[p];
+        m_hits[p] += other.m_hits[p];
+        m_wasted[p] += other.m_wasted[p];
+        if (other.m_maxMoveMicros[p] > m_maxMoveMicros[p])
+            m_maxMoveMicros[p] = other.m_maxMoveMicros[p];
+        m_slowMoves[p] += other.m_slowMoves[p];
+        m_forfeits[p] += other.m_forfeits[p];
+        for (int b = 0; b <= MAXSHOTBUCKET; b++)
+            m_shotsToWin[p][b] += other.m_shotsToWin[p][b];
+        for (int s = 0; s < MAXSHIPS; s++)
+        {
+            m_sunk[p][s] += other.m_sunk[p][s];
+            m_sinkTurnTotal[p][s] += other.m_sinkTurnTotal[p][s];
+        }
+    }
+}
+
+double MatchStats::winRate() const
+{
+    long long finished = m_wins[0] + m_wins[1];
+    return finished == 0 ? 0 : double(m_wins[0]) / finished;
+}
+
+void MatchStats::winRateInterval(double z, double& low, double& high) const
+{
+    double n = double(m_wins[0] + m_wins[1]);
+    if (n == 0)
+    {
+        low = 0;
+        high = 1;
+        return;
+    }
+    double p = winRate();
+    double denominator = 1 + z * z / n;
+    double center = (p + z * z / (2 * n)) / denominator;
+    double halfWidth = z * sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / denominator;
+    low = center - halfWidth;
+    high = center + halfWidth;
+}
+
+double MatchStats::meanShotsToWin(int player) const
+{
+    long long total = 0;
+    for (int b = 0; b <= MAXSHOTBUCKET; b++)
+        total += b * m_shotsToWin[player][b];
+    return m_wins[player] == 0 ? 0 : double(total) / m_wins[player];
+}
+
+int MatchStats::shotsToWinQuantile(int player, double q) const
+{
+    long long seen = 0;
+    for (int b = 0; b <= MAXSHOTBUCKET; b++)
+    {
+        seen += m_shotsToWin[player][b];
+        if (seen > 0  &&  seen >= q * m_wins[player])
+            return b;
+    }
+    return MAXSHOTBUCKET;
+}
+
+long long MatchStats::shotsToWinCount(int player, int shots) const
+{
+    return m_shotsToWin[player][shots < MAXSHOTBUCKET ? shots : MAXSHOTBUCKET];
+}
+
+double MatchStats::meanTimeToSink(int player, int shipId) const
+{
+    if (m_sunk[player][shipId] == 0)
+        return -1;
+    return double(m_sinkTurnTotal[player][shipId]) / m_sunk[player][shipId];
+}
+
+void MatchStats::print(ostream& out, const string& nameA, const string& nameB,
+                       int nShips) const
+{
+    double low, high;
+    winRateInterval(1.96, low, high);
+    out << nameA << " won " << m_wins[0] << " and " << nameB << " won " << m_wins[1]
+        << " of " << m_games << " games";
+    if (unfinished() > 0)
+    {
+        out << " (" << unfinished() << " unfinished";
+        if (m_timeouts > 0)
+            out << ", " << m_timeouts << " out of turns or time";
+        out << ")";
+    }
+    out << "." << endl;
+    out << nameA << "'s win rate: " << winRate() << " (95% interval "
+        << low << " to " << high << ")" << endl;
+    out << "The player moving first won " << m_firstMoverWins << " games." << endl;
+
+    const string names[2] = { nameA, nameB };
+    for (int p = 0; p < 2; p++)
+    {
+        out << names[p] << ": " << m_shots[p] << " shots, " << m_hits[p] << " hits, "
+            << m_wasted[p] << " wasted, slowest shot " << m_maxMoveMicros[p] << " us";
+        if (m_slowMoves[p] > 0)
+            out << " (" << m_slowMoves[p] << " over budget)";
+        if (m_forfeits[p] > 0)
+            out << ", forfeited " << m_forfeits[p] << " games";
+        if (m_wins[p] > 0)
+            out << "; shots to win: mean " << meanShotsToWin(p)
+                << ", median " << shotsToWinQuantile(p, 0.5)
+                << ", 90th percentile " << shotsToWinQuantile(p, 0.9);
+        out << endl;
+        out << "  average shot that sank each ship:";
+        for (int s = 0; s < nShips  &&  s < MAXSHIPS; s++)
+            out << " " << meanTimeToSink(p, s);
+        out << endl;
+    }
+}
+
+vector<long long*> MatchStats::counters()
+{
+    vector<long long*> result;
+    result.push_back(&m_games);
+    result.push_back(&m_firstMoverWins);
+    result.push_back(&m_timeouts);
+    for (int p = 0; p < 2; p++)
+    {
+        result.push_back(&m_wins[p]);
+        result.push_back(&m_shots[p]);
+        result.push_back(&m_hits[p]);
+        result.push_back(&m_wasted[p]);
+        result.push_back(&m_maxMoveMicros[p]);
+        result.push_back(&m_slowMoves[p]);
+        result.push_back(&m_forfeits[p]);
+        for (int b = 0; b <= MAXSHOTBUCKET; b++)
+            result.push_back(&m_shotsToWin[p][b]);
+        for (int s = 0; s < MAXSHIPS; s++)
+        {
+            result.push_back(&m_sunk[p][s]);
+            result.push_back(&m_sinkTurnTotal[p][s]);
+        }
+    }
+    return result;
+}
+
+//"BSMS", the number of totals (4 bytes), then each total (8 bytes)
+void MatchStats::save(ostream& out) const
+{
+    vector<long long*> values = const_cast<MatchStats*>(this)->counters();
+    vector<unsigned char> bytes(8 + 8 * values.size());
+    memcpy(&bytes[0], "BSMS", 4);
+    for (int i = 0; i < 4; i++)
+        bytes[4 + i] = static_cast<unsigned char>(values.size() >> (8 * i));
+    for (size_t k = 0; k < values.size(); k++)
+        for (int i = 0; i < 8; i++)
+            bytes[8 + 8 * k + i] = static_cast<unsigned char>(uint64_t(*values[k]) >> (8 * i));
+    out.write(reinterpret_cast<const char*>(&bytes[0]), bytes.size());
+}
+
+bool MatchStats::load(istream& in)
+{
+    vector<long long*> values = counters();
+    vector<unsigned char> bytes(8 + 8 * values.size());
+    if (!in.read(reinterpret_cast<char*>(&bytes[0]), bytes.size()))
+        return false;
+    //A different MAXSHIPS or board size changes the number of totals
+    uint32_t count = 0;
+    for (int i = 0; i < 4; i++)
+        count |= uint32_t(bytes[4 + i]) << (8 * i);
+    if (memcmp(&bytes[0], "BSMS", 4) != 0  ||  count != values.size())
+        return false;
+    for (size_t k = 0; k < values.size(); k++)
+    {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++)
+            v |= uint64_t(bytes[8 + 8 * k + i]) << (8 * i);
+        *values[k] = (long long)(v);
+    }
+    return true;
+}
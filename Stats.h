@@ -0,0 +1,81 @@
+#ifndef STATS_INCLUDED
+#define STATS_INCLUDED
+
+#include "globals.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct GameRecord;
+
+  // Running totals for a match between players A and B, who may sit in
+  // either seat.  Each game updates the totals and is then forgotten, so
+  // the memory used doesn't grow with the number of games.  Totals kept by
+  // different threads can be merged.
+class MatchStats
+{
+  public:
+      // Games won in more shots than this all land in the last bucket
+    static const int MAXSHOTBUCKET = 2 * MAXROWS * MAXCOLS;
+
+    MatchStats();
+    void add(const GameRecord& record, int seatOfA);
+    void merge(const MatchStats& other);
+
+    long long games() const { return m_games; }
+    long long wins(int player) const { return m_wins[player]; }
+    long long unfinished() const { return m_games - m_wins[0] - m_wins[1]; }
+    long long firstMoverWins() const { return m_firstMoverWins; }
+    long long wastedShots(int player) const { return m_wasted[player]; }
+      // Fraction of finished games player A won, and a Wilson score
+      // interval around it for the given normal quantile (1.96 for 95%)
+    double winRate() const;
+    void winRateInterval(double z, double& low, double& high) const;
+    double meanShotsToWin(int player) const;
+      // Smallest shot count s such that at least the fraction q of
+      // player's wins took s shots or fewer
+    int shotsToWinQuantile(int player, double q) const;
+    long long shotsToWinCount(int player, int shots) const;
+      // Average shot number at which player sank the opponent's ship, or -1
+    double meanTimeToSink(int player, int shipId) const;
+    long long shipsSunk(int player, int shipId) const { return m_sunk[player][shipId]; }
+      // Longest player took to choose a shot, and how many shots took
+      // longer than the game's move budget
+    long long maxMoveMicros(int player) const { return m_maxMoveMicros[player]; }
+    long long slowMoves(int player) const { return m_slowMoves[player]; }
+      // Games player lost by wasting too many shots, and games stopped by
+      // the turn or time limit
+    long long forfeits(int player) const { return m_forfeits[player]; }
+    long long timeouts() const { return m_timeouts; }
+
+    void print(std::ostream& out, const std::string& nameA, const std::string& nameB,
+               int nShips) const;
+
+      // Every total as raw little-endian binary, so a run can be saved and
+      // picked up again or combined with totals from another process.  load
+      // returns false, leaving the totals alone, if in doesn't hold totals
+      // written by save.
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
+
+  private:
+      // Index 0 is player A and 1 is player B
+    long long m_games;
+    long long m_wins[2];
+    long long m_firstMoverWins;
+    long long m_shots[2];
+    long long m_hits[2];
+    long long m_wasted[2];
+    long long m_shotsToWin[2][MAXSHOTBUCKET + 1];
+    long long m_sunk[2][MAXSHIPS];
+    long long m_sinkTurnTotal[2][MAXSHIPS];
+    long long m_maxMoveMicros[2];
+    long long m_slowMoves[2];
+    long long m_forfeits[2];
+    long long m_timeouts;
+
+      // Every total, in the order save writes them
+    std::vector<long long*> counters();
+};
+
+#endif // STATS_INCLUDED
@@ -0,0 +1,105 @@
+#include "Symmetry.h"
+
+using namespace std;
+
+int nSymmetries(int nRows, int nCols)
+{
+    return nRows == nCols ? 8 : 4;
+}
+
+Point transformPoint(Symmetry s, Point p, int nRows, int nCols)
+{
+    int lastRow = nRows - 1;
+    int lastCol = nCols - 1;
+    switch (s)
+    {
+      default:
+      case SYM_IDENTITY:       return p;
+      case SYM_FLIP_ROWS:      return Point(lastRow - p.r, p.c);
+      case SYM_FLIP_COLS:      return Point(p.r, lastCol - p.c);
+      case SYM_ROTATE_180:     return Point(lastRow - p.r, lastCol - p.c);
+      case SYM_TRANSPOSE:      return Point(p.c, p.r);
+      case SYM_ROTATE_90:      return Point(p.c, lastRow - p.r);
+      case SYM_ROTATE_270:     return Point(lastCol - p.c, p.r);
+      case SYM_ANTITRANSPOSE:  return Point(lastCol - p.c, lastRow - p.r);
+    }
+}
+
+Symmetry inverseSymmetry(Symmetry s)
+{
+    //Every symmetry but the quarter turns is its own inverse
+    if (s == SYM_ROTATE_90)
+        return SYM_ROTATE_270;
+    if (s == SYM_ROTATE_270)
+        return SYM_ROTATE_90;
+    return s;
+}
+
+BoardSymmetries::BoardSymmetries(int nRows, int nCols)
+ : m_count(nSymmetries(nRows, nCols))
+{
+    for (int s = 0; s < NSYMMETRIES; s++)
+        for (int cell = 0; cell < MAXCELLS; cell++)
+            m_image[s][cell] = -1;
+    for (int s = 0; s < m_count; s++)
+        for (int r = 0; r < nRows; r++)
+            for (int c = 0; c < nCols; c++)
+            {
+                Point image = transformPoint(Symmetry(s), Point(r, c), nRows, nCols);
+                m_image[s][cellIndex(Point(r, c))] = static_cast<signed char>(cellIndex(image));
+            }
+}
+
+Knowledge BoardSymmetries::transform(Symmetry s, const Knowledge& k) const
+{
+    Knowledge result;
+    result.shot = transform(s, k.shot);
+    result.hit = transform(s, k.hit);
+    result.sunkAt = k.sunkAt;
+    for (size_t i = 0; i < result.sunkAt.size(); i++)
+        if (result.sunkAt[i] >= 0)
+            result.sunkAt[i] = m_image[s][result.sunkAt[i]];
+    return result;
+}
+
+Knowledge BoardSymmetries::canonical(const Knowledge& k, Symmetry* symmetry) const
+{
+    Knowledge best = k;
+    Symmetry bestSymmetry = SYM_IDENTITY;
+    for (int s = 1; s < m_count; s++)
+    {
+        //Most copies lose on shot alone, so don't build the rest of them
+        Bitboard shot = transform(Symmetry(s), k.shot);
+        if (best.shot < shot)
+            continue;
+        Knowledge copy = transform(Symmetry(s), k);
+        if (copy.shot < best.shot  ||
+            (copy.shot == best.shot  &&  (copy.hit < best.hit  ||
+                            (copy.hit == best.hit  &&  copy.sunkAt < best.sunkAt))))
+        {
+            best = copy;
+            bestSymmetry = Symmetry(s);
+        }
+    }
+    if (symmetry != nullptr)
+        *symmetry = bestSymmetry;
+    return best;
+}
+
+Bitboard BoardSymmetries::canonical(const Bitboard& b, Symmetry* symmetry) const
+{
+    Bitboard best = b;
+    Symmetry bestSymmetry = SYM_IDENTITY;
+    for (int s = 1; s < m_count; s++)
+    {
+        Bitboard copy = transform(Symmetry(s), b);
+        if (copy < best)
+        {
+            best = copy;
+            bestSymmetry = Symmetry(s);
+        }
+    }
+    if (symmetry != nullptr)
+        *symmetry = bestSymmetry;
+    return best;
+}
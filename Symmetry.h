@@ -0,0 +1,74 @@
+#ifndef SYMMETRY_INCLUDED
+#define SYMMETRY_INCLUDED
+
+#include "Bitboard.h"
+#include "Fleet.h"
+#include <cstdint>
+
+  // The symmetries of a board: the ways of turning and flipping it that
+  // leave it covering the same cells.  A square board has eight (the
+  // dihedral group of the square); any other rectangle has only the four
+  // that don't swap rows with columns.  Positions that are symmetric copies
+  // of each other are equally good to be in, so a cache of analysis can
+  // store one entry per class of symmetric positions, keyed by the class's
+  // canonical form: the copy that compares lowest.
+
+enum Symmetry
+{
+    SYM_IDENTITY,
+    SYM_FLIP_ROWS,       // row r goes to row nRows-1-r
+    SYM_FLIP_COLS,       // column c goes to column nCols-1-c
+    SYM_ROTATE_180,
+      // Square boards only
+    SYM_TRANSPOSE,       // (r,c) goes to (c,r)
+    SYM_ROTATE_90,       // clockwise
+    SYM_ROTATE_270,
+    SYM_ANTITRANSPOSE,   // (r,c) goes to (n-1-c,n-1-r)
+    NSYMMETRIES
+};
+
+  // How many of the symmetries above, starting from SYM_IDENTITY, a board
+  // with the given number of rows and columns has
+int nSymmetries(int nRows, int nCols);
+
+  // Where a symmetry of an nRows x nCols board takes point p
+Point transformPoint(Symmetry s, Point p, int nRows, int nCols);
+
+  // The symmetry that undoes s
+Symmetry inverseSymmetry(Symmetry s);
+
+  // The symmetries of one board size, with the image of every cell worked
+  // out in advance so that whole sets of cells transform quickly
+class BoardSymmetries
+{
+  public:
+    BoardSymmetries(int nRows, int nCols);
+    int count() const { return m_count; }
+      // Where s takes the given cell, which must be on the board
+    int transformCell(Symmetry s, int cell) const { return m_image[s][cell]; }
+      // Every cell of b moved where s takes it; b must lie on the board
+    Bitboard transform(Symmetry s, Bitboard b) const
+    {
+        if (s == SYM_IDENTITY)
+            return b;
+        Bitboard result;
+        while (b.any())
+            result.set(m_image[s][b.popLowest()]);
+        return result;
+    }
+    Knowledge transform(Symmetry s, const Knowledge& k) const;
+      // The lowest of the copies of k under the board's symmetries, in the
+      // order shot, then hit, then sunkAt.  If symmetry isn't null, it's set
+      // to a symmetry that takes k to that copy.
+    Knowledge canonical(const Knowledge& k, Symmetry* symmetry = nullptr) const;
+      // The same for a set of cells
+    Bitboard canonical(const Bitboard& b, Symmetry* symmetry = nullptr) const;
+      // A hash of k that's the same for every symmetric copy of it
+    std::uint64_t canonicalHash(const Knowledge& k) const { return canonical(k).hash(); }
+
+  private:
+    int m_count;
+    signed char m_image[NSYMMETRIES][MAXCELLS];
+};
+
+#endif // SYMMETRY_INCLUDED
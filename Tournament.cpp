@@ -0,0 +1,372 @@
+#include "Tournament.h"
+#include "Game.h"
+#include "Player.h"
+#include "Replay.h"
+#include "Spectator.h"
+#include "Fleet.h"
+#include "Columns.h"
+#include "Trace.h"
+#include "Alloc.h"
+#include "globals.h"
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+
+using namespace std;
+
+//SplitMix64, so nearby indexes give unrelated seeds
+unsigned long long gameSeed(unsigned long long seed, long long gameIndex)
+{
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL * (unsigned long long)(gameIndex + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+int defaultThreadCount()
+{
+    unsigned n = thread::hardware_concurrency();
+    return n == 0 ? 1 : int(n);
+}
+
+void parallelFor(long long n, int nThreads, const function<void(long long)>& work)
+{
+    if (nThreads <= 0)
+        nThreads = defaultThreadCount();
+    if (nThreads > n)
+        nThreads = int(n);
+
+    //Each thread keeps claiming the next unclaimed index until none are left
+    atomic<long long> next(0);
+    auto worker = [&]() {
+        for (long long i = next++; i < n; i = next++)
+            work(i);
+    };
+    vector<thread> threads;
+    for (int t = 1; t < nThreads; t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+}
+
+shared_ptr<const FleetCatalog> matchFleet(const MatchOptions& options)
+{
+    if (options.fleet != nullptr)
+        return options.fleet;
+    Game g(options.rows, options.cols);
+    if (options.addShips != nullptr  &&  !options.addShips(g))
+        return nullptr;
+    return g.catalog();
+}
+
+int playMatchGame(const MatchOptions& options, long long gameIndex, GameRecord& record)
+{
+    TRACE_SPAN("game");
+    AllocationScope setup(ALLOC_SETUP);
+    int seatOfA = int(gameIndex % 2);
+    record.clear();
+    unsigned long long seed = gameSeed(options.seed, gameIndex);
+    seedRandom(seed);
+    //A shared fleet saves working out every ship's placements again for each game
+    Game g(options.fleet != nullptr ? options.fleet
+                                    : make_shared<const FleetCatalog>(options.rows, options.cols));
+    if (options.fleet == nullptr  &&  options.addShips != nullptr  &&  !options.addShips(g))
+        return seatOfA;
+    g.setLimits(options.limits);
+    //With nothing to observe or time, known pairings take the devirtualized loop
+    const string& first = (seatOfA == 0 ? options.typeA : options.typeB);
+    const string& second = (seatOfA == 0 ? options.typeB : options.typeA);
+    if (options.replay == nullptr  &&  options.spectators == nullptr  &&  !options.salvo  &&  options.moveBudgetMicros <= 0  &&
+                                            playKnownPairing(first, second, g, record))
+        return seatOfA;
+    g.setMoveBudget(options.moveBudgetMicros);
+    ObserverGroup observers;
+    ReplayRecorder* recorder = nullptr;
+    if (options.replay != nullptr)
+    {
+        recorder = new ReplayRecorder(*options.replay);
+        recorder->beginGame(seed);
+        observers.add(recorder);
+    }
+    SpectatorRecorder* spectator = nullptr;
+    if (options.spectators != nullptr)
+    {
+        spectator = new SpectatorRecorder(*options.spectators, g);
+        spectator->beginGame(uint64_t(gameIndex));
+        observers.add(spectator);
+    }
+    if (recorder != nullptr  ||  spectator != nullptr)
+        g.setObserver(&observers);
+    Player* a = createPlayer(options.typeA, options.typeA, g);
+    Player* b = createPlayer(options.typeB, options.typeB, g);
+    Player* p1 = (seatOfA == 0 ? a : b);
+    Player* p2 = (seatOfA == 0 ? b : a);
+    if (options.salvo)
+        g.playSalvo(p1, p2, options.salvoShots, &record);
+    else
+        g.playQuietly(p1, p2, &record);
+    delete a;
+    delete b;
+    delete recorder;
+    delete spectator;
+    return seatOfA;
+}
+
+//Play games first through last-1 of the match in parallel
+static MatchStats playGames(const MatchOptions& options, long long first, long long last)
+{
+    //Each thread plays a contiguous slice of the games into its own totals
+    long long n = last - first;
+    int nThreads = options.nThreads > 0 ? options.nThreads : defaultThreadCount();
+    if (nThreads > n)
+        nThreads = n > 0 ? int(n) : 1;
+    vector<MatchStats> partial(nThreads);
+    parallelFor(nThreads, nThreads, [&](long long t) {
+        GameRecord record;
+        long long begin = first + n * t / nThreads;
+        long long end = first + n * (t + 1) / nThreads;
+        for (long long k = begin; k < end; k++)
+        {
+            int seatOfA = playMatchGame(options, k, record);
+            partial[t].add(record, seatOfA);
+            if (options.columns != nullptr)
+                options.columns->add(k, gameSeed(options.seed, k), seatOfA, record);
+        }
+    });
+
+    MatchStats total;
+    for (int t = 0; t < nThreads; t++)
+        total.merge(partial[t]);
+    return total;
+}
+
+//Everything that decides the outcome of a match's games, hashed, so a
+//checkpoint or shard result from some other match is never used.  The
+//shard isn't part of it, so every shard of a match has the same fingerprint.
+static uint64_t matchFingerprint(const MatchOptions& options)
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+    auto mix = [&h](uint64_t value) { h = (h ^ value) * 0x100000001B3ULL; };
+    auto mixString = [&mix](const string& str) {
+        mix(str.size());
+        for (size_t i = 0; i < str.size(); i++)
+            mix(static_cast<unsigned char>(str[i]));
+    };
+    mixString(options.typeA);
+    mixString(options.typeB);
+    mix(uint64_t(options.nGames));
+    mix(options.seed);
+    mix(options.salvo);
+    mix(uint64_t(options.salvoShots));
+    mix(uint64_t(options.limits.maxTurns));
+    mix(uint64_t(options.limits.maxWasted));
+    mix(uint64_t(options.limits.maxMillis));
+    shared_ptr<const FleetCatalog> fleet = matchFleet(options);
+    if (fleet != nullptr)
+    {
+        mix(uint64_t(fleet->rows()));
+        mix(uint64_t(fleet->cols()));
+        for (int s = 0; s < fleet->nShips(); s++)
+        {
+            mix(uint64_t(fleet->shipLength(s)));
+            mix(static_cast<unsigned char>(fleet->shipSymbol(s)));
+        }
+    }
+    return h;
+}
+
+//"BSCP", the match fingerprint (8 bytes), next game to play (8), then the totals
+static void writeUint64(ostream& out, uint64_t value)
+{
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++)
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    out.write(reinterpret_cast<const char*>(bytes), 8);
+}
+
+static bool readUint64(istream& in, uint64_t& value)
+{
+    unsigned char bytes[8];
+    if (!in.read(reinterpret_cast<char*>(bytes), 8))
+        return false;
+    value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= uint64_t(bytes[i]) << (8 * i);
+    return true;
+}
+
+//A checkpoint belongs to one shard of one match
+static uint64_t checkpointFingerprint(const MatchOptions& options)
+{
+    uint64_t h = matchFingerprint(options);
+    h = (h ^ uint64_t(options.shardIndex)) * 0x100000001B3ULL;
+    return (h ^ uint64_t(options.shardCount)) * 0x100000001B3ULL;
+}
+
+//The first game of the shard, and one past its last
+static void shardSlice(const MatchOptions& options, long long& first, long long& last)
+{
+    int count = options.shardCount > 0 ? options.shardCount : 1;
+    first = options.nGames * options.shardIndex / count;
+    last = options.nGames * (options.shardIndex + 1) / count;
+}
+
+//The checkpoint holds the index of the next game to play, which must lie
+//within this shard
+static bool readCheckpoint(const MatchOptions& options, long long& next, MatchStats& stats)
+{
+    ifstream in(options.checkpointPath.c_str(), ios::binary);
+    long long first, last;
+    shardSlice(options, first, last);
+    char magic[4];
+    uint64_t fingerprint, done;
+    if (!in.read(magic, 4)  ||  string(magic, 4) != "BSCP"  ||
+        !readUint64(in, fingerprint)  ||  fingerprint != checkpointFingerprint(options)  ||
+        !readUint64(in, done)  ||  done < uint64_t(first)  ||  done > uint64_t(last))
+        return false;
+    MatchStats saved;
+    if (!saved.load(in))
+        return false;
+    next = (long long)(done);
+    stats = saved;
+    return true;
+}
+
+//Written to a temporary file and renamed, so an interruption mid-write
+//leaves the previous checkpoint intact
+static bool writeCheckpoint(const MatchOptions& options, long long next,
+                            const MatchStats& stats)
+{
+    string temp = options.checkpointPath + ".tmp";
+    {
+        ofstream out(temp.c_str(), ios::binary | ios::trunc);
+        out.write("BSCP", 4);
+        writeUint64(out, checkpointFingerprint(options));
+        writeUint64(out, uint64_t(next));
+        stats.save(out);
+        out.flush();
+        if (!out)
+            return false;
+    }
+    return rename(temp.c_str(), options.checkpointPath.c_str()) == 0;
+}
+
+MatchStats runMatch(const MatchOptions& matchOptions)
+{
+    //Build the fleet once for all the games
+    MatchOptions options = matchOptions;
+    options.fleet = matchFleet(matchOptions);
+    long long first, last;
+    shardSlice(options, first, last);
+    if (options.checkpointPath.empty()  &&  !options.progress)
+        return playGames(options, first, last);
+
+    long long next = first;
+    MatchStats total;
+    if (!options.checkpointPath.empty())
+        readCheckpoint(options, next, total);
+    //Stop at each checkpoint and each progress report, whichever is sooner
+    long long checkpointChunk = options.checkpointPath.empty() ? 0 : options.checkpointEvery;
+    long long progressChunk = !options.progress ? 0 :
+                options.progressEvery > 0 ? options.progressEvery : options.checkpointEvery;
+    long long nextCheckpoint = checkpointChunk > 0 ? next + checkpointChunk : last;
+    long long nextProgress = progressChunk > 0 ? next + progressChunk : last;
+    while (next < last)
+    {
+        long long end = min(min(nextCheckpoint, nextProgress), last);
+        total.merge(playGames(options, next, end));
+        next = end;
+        if (!options.checkpointPath.empty()  &&  (next == nextCheckpoint  ||  next == last))
+        {
+            writeCheckpoint(options, next, total);
+            if (checkpointChunk > 0)
+                nextCheckpoint += checkpointChunk;
+        }
+        if (options.progress  &&  (next == nextProgress  ||  next == last))
+        {
+            options.progress(total);
+            if (progressChunk > 0)
+                nextProgress += progressChunk;
+        }
+    }
+    return total;
+}
+
+//"BSSH", the match fingerprint (8 bytes), shard index (8), shard count (8),
+//then the totals
+bool writeShardResult(const string& path, const MatchOptions& options, const MatchStats& stats)
+{
+    ofstream out(path.c_str(), ios::binary | ios::trunc);
+    out.write("BSSH", 4);
+    writeUint64(out, matchFingerprint(options));
+    writeUint64(out, uint64_t(options.shardIndex));
+    writeUint64(out, uint64_t(options.shardCount > 0 ? options.shardCount : 1));
+    stats.save(out);
+    out.flush();
+    return bool(out);
+}
+
+bool mergeShardResults(const vector<string>& paths, MatchStats& total, string& error)
+{
+    MatchStats merged;
+    uint64_t matchPrint = 0;
+    vector<bool> seen;
+    for (size_t k = 0; k < paths.size(); k++)
+    {
+        ifstream in(paths[k].c_str(), ios::binary);
+        char magic[4];
+        uint64_t fingerprint, index, count;
+        MatchStats shard;
+        if (!in.read(magic, 4)  ||  string(magic, 4) != "BSSH"  ||
+            !readUint64(in, fingerprint)  ||  !readUint64(in, index)  ||
+            !readUint64(in, count)  ||  count == 0  ||  index >= count  ||  !shard.load(in))
+        {
+            error = paths[k] + " is not a shard result";
+            return false;
+        }
+        //Every shard needs a file of its own, so more shards than files
+        //means some are missing; checking first also keeps a corrupt count
+        //from asking for a huge table
+        if (count > paths.size())
+        {
+            error = paths[k] + " is one of " + to_string(count) + " shards, but only " +
+                    to_string(paths.size()) + " results were given";
+            return false;
+        }
+        if (k == 0)
+        {
+            matchPrint = fingerprint;
+            seen.assign(count, false);
+        }
+        else if (fingerprint != matchPrint  ||  count != seen.size())
+        {
+            error = paths[k] + " is from a different match";
+            return false;
+        }
+        if (seen[index])
+        {
+            error = paths[k] + " repeats shard " + to_string(index);
+            return false;
+        }
+        seen[index] = true;
+        merged.merge(shard);
+    }
+    for (size_t i = 0; i < seen.size(); i++)
+        if (!seen[i])
+        {
+            error = "shard " + to_string(i) + " is missing";
+            return false;
+        }
+    if (paths.empty())
+    {
+        error = "no shard results given";
+        return false;
+    }
+    total = merged;
+    return true;
+}
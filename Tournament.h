@@ -0,0 +1,128 @@
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include "Stats.h"
+#include "Game.h"
+#include <functional>
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <memory>
+#include <vector>
+
+class ReplayWriter;
+class SpectatorFeed;
+class ColumnWriter;
+
+  // Adds the ships for a game to a freshly constructed Game
+typedef bool (*FleetSetup)(Game& g);
+
+  // The seed for game number gameIndex of a run started from seed.  Seeding
+  // each game separately makes its outcome independent of which thread
+  // played it or what was played before.
+unsigned long long gameSeed(unsigned long long seed, long long gameIndex);
+
+  // The number of threads to use when the caller asked for 0
+int defaultThreadCount();
+
+  // Call work(i) for every i from 0 to n-1, spread over nThreads threads
+void parallelFor(long long n, int nThreads, const std::function<void(long long)>& work);
+
+  // Like parallelFor, but each result of produce(i) is handed to consume
+  // one at a time and in order of i, whatever order they finish in.  Once
+  // consume returns false, no more results are consumed and remaining work
+  // is skipped.
+template <class Result>
+void parallelInOrder(long long n, int nThreads,
+                     const std::function<Result(long long)>& produce,
+                     const std::function<bool(long long, const Result&)>& consume)
+{
+    std::map<long long, Result> pending;
+    std::mutex consumeMutex;
+    std::atomic<bool> stop(false);
+    long long nextToConsume = 0;
+    parallelFor(n, nThreads, [&](long long i) {
+        if (stop)
+            return;
+        Result result = produce(i);
+        std::lock_guard<std::mutex> lock(consumeMutex);
+        if (stop)
+            return;
+        pending.insert(std::make_pair(i, result));
+        typename std::map<long long, Result>::iterator it;
+        while (!stop  &&  (it = pending.find(nextToConsume)) != pending.end())
+        {
+            if (!consume(nextToConsume, it->second))
+                stop = true;
+            pending.erase(it);
+            nextToConsume++;
+        }
+    });
+}
+
+  // A match of nGames games between createPlayer types A and B
+struct MatchOptions
+{
+    int rows = 10;
+    int cols = 10;
+    FleetSetup addShips = nullptr;
+      // If not null, the board and ships, shared by every game, in place
+      // of rows, cols and addShips
+    std::shared_ptr<const FleetCatalog> fleet;
+    std::string typeA = "good";
+    std::string typeB = "mediocre";
+    long long nGames = 50;
+    int nThreads = 0;                   // 0 means one per hardware thread
+    unsigned long long seed = 1;
+    ReplayWriter* replay = nullptr;     // if not null, every game is recorded here
+    SpectatorFeed* spectators = nullptr;  // if not null, every game is published here
+    ColumnWriter* columns = nullptr;    // if not null, every game's result is added here
+    long long moveBudgetMicros = 0;     // if positive, shots slower than this are counted
+    bool salvo = false;                 // play salvo games...
+    int salvoShots = 0;                 // ...of this many shots a turn, 0 for one per ship afloat
+      // No sane player needs more turns than there are cells, so by default
+      // only a runaway game is stopped
+    GameLimits limits = GameLimits{ 2 * MAXROWS * MAXCOLS, 0, 0 };
+      // If not empty, the match is played in chunks of checkpointEvery
+      // games and the totals so far are saved here after each chunk.  A
+      // later run of the same match picks up after the last chunk saved.
+    std::string checkpointPath;
+    long long checkpointEvery = 100000;
+      // If set, this is called with the totals so far every progressEvery
+      // games (every checkpointEvery games if that's 0) and at the end
+    std::function<void(const MatchStats&)> progress;
+    long long progressEvery = 0;
+      // Play only this shard's share of the nGames games: the match is cut
+      // into shardCount contiguous slices, and this is slice shardIndex
+    int shardIndex = 0;
+    int shardCount = 1;
+};
+
+  // The match's board and ships: options.fleet if it's set, otherwise a
+  // catalog built from rows, cols and addShips, or null if addShips fails
+std::shared_ptr<const FleetCatalog> matchFleet(const MatchOptions& options);
+
+  // Play game number gameIndex of the match quietly.  Player A moves first
+  // in even-numbered games.  Returns the seat A sat in.
+int playMatchGame(const MatchOptions& options, long long gameIndex, GameRecord& record);
+
+  // Play the whole match in parallel and return its statistics.  Since
+  // every game has its own seed, a match resumed from a checkpoint ends
+  // with exactly the totals it would have had if it had run straight
+  // through.
+MatchStats runMatch(const MatchOptions& options);
+
+  // Save the totals one shard of a match produced, as raw binary, along
+  // with which shard it was and a fingerprint of the match
+bool writeShardResult(const std::string& path, const MatchOptions& options,
+                      const MatchStats& stats);
+
+  // Combine the shard results in paths into the totals of the whole match.
+  // Returns false, with a reason in error, unless the files all come from
+  // the same match and hold every one of its shards exactly once.
+bool mergeShardResults(const std::vector<std::string>& paths, MatchStats& total,
+                       std::string& error);
+
+#endif // TOURNAMENT_INCLUDED
@@ -0,0 +1,142 @@
+#include "Trace.h"
+#include "Alloc.h"
+#include <fstream>
+#include <vector>
+#include <mutex>
+
+using namespace std;
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char* name;
+        long long start;
+        long long end;
+    };
+
+    struct ThreadTrace
+    {
+        int tid;
+        vector<TraceEvent> events;
+        long long dropped = 0;
+    };
+
+    //Every thread's buffer, kept after the thread ends so it can still be written
+    mutex registryMutex;
+    vector<ThreadTrace*> registry;
+    const size_t INITIALTRACEEVENTS = 65536;
+
+    //The tracer's own allocations are no part of the game being traced, so
+    //they're counted as ALLOC_OTHER, not against the phase they happen in
+    ThreadTrace* threadTrace()
+    {
+        static thread_local ThreadTrace* trace = nullptr;
+        if (trace == nullptr)
+        {
+            AllocationScope tracer(ALLOC_OTHER);
+            lock_guard<mutex> lock(registryMutex);
+            trace = new ThreadTrace;
+            trace->events.reserve(INITIALTRACEEVENTS);
+            trace->tid = int(registry.size()) + 1;
+            registry.push_back(trace);
+        }
+        return trace;
+    }
+
+    //Names come from the source, but escape them in case
+    void writeJsonString(ofstream& out, const char* s)
+    {
+        out << '"';
+        for ( ; *s != '\0'; s++)
+        {
+            if (*s == '"'  ||  *s == '\\')
+                out << '\\';
+            out << *s;
+        }
+        out << '"';
+    }
+}
+
+bool traceCompiledIn()
+{
+#ifdef BATTLESHIP_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void traceRecord(const char* name, long long startNanos, long long endNanos)
+{
+    ThreadTrace* trace = threadTrace();
+    if ((long long)(trace->events.size()) >= MAXTRACEEVENTS)
+    {
+        trace->dropped++;
+        return;
+    }
+    TraceEvent event = { name, startNanos, endNanos };
+    if (trace->events.size() == trace->events.capacity())
+    {
+        AllocationScope tracer(ALLOC_OTHER);
+        trace->events.push_back(event);
+    }
+    else
+        trace->events.push_back(event);
+}
+
+bool writeChromeTrace(const string& path)
+{
+    lock_guard<mutex> lock(registryMutex);
+    ofstream out(path.c_str());
+    if (!out)
+        return false;
+
+    //Times are in microseconds from the earliest span
+    long long origin = -1;
+    for (size_t t = 0; t < registry.size(); t++)
+        for (size_t i = 0; i < registry[t]->events.size(); i++)
+            if (origin < 0  ||  registry[t]->events[i].start < origin)
+                origin = registry[t]->events[i].start;
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    out.setf(ios::fixed);
+    out.precision(3);
+    for (size_t t = 0; t < registry.size(); t++)
+    {
+        const ThreadTrace& trace = *registry[t];
+        for (size_t i = 0; i < trace.events.size(); i++)
+        {
+            const TraceEvent& e = trace.events[i];
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(out, e.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << trace.tid
+                << ",\"ts\":" << (e.start - origin) / 1000.0
+                << ",\"dur\":" << (e.end - e.start) / 1000.0 << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    out.flush();
+    return bool(out);
+}
+
+void clearTrace()
+{
+    lock_guard<mutex> lock(registryMutex);
+    for (size_t t = 0; t < registry.size(); t++)
+    {
+        registry[t]->events.clear();
+        registry[t]->dropped = 0;
+    }
+}
+
+long long droppedTraceEvents()
+{
+    lock_guard<mutex> lock(registryMutex);
+    long long total = 0;
+    for (size_t t = 0; t < registry.size(); t++)
+        total += registry[t]->dropped;
+    return total;
+}
@@ -0,0 +1,67 @@
+#ifndef TRACE_INCLUDED
+#define TRACE_INCLUDED
+
+#include <string>
+#include <chrono>
+
+  // Timed spans around the phases of a game, for finding slow decisions
+  // and idle threads.  Write
+  //
+  //     TRACE_SPAN("recommendAttack");
+  //
+  // at the top of a block to record how long the rest of the block takes.
+  // Spans are only recorded when the program is compiled with
+  // BATTLESHIP_TRACE defined; otherwise TRACE_SPAN expands to nothing and
+  // costs nothing.  Each thread records into its own buffer, so recording
+  // takes no lock.  After the traced work is done, writeChromeTrace saves
+  // every thread's spans in the Chrome trace event format, which
+  // chrome://tracing and Perfetto can display as a timeline.
+
+#ifdef BATTLESHIP_TRACE
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#else
+#define TRACE_SPAN(name) ((void)0)
+#endif
+
+  // True if this program was compiled to record spans
+bool traceCompiledIn();
+
+  // Record a span on the calling thread.  name must be a string literal,
+  // or at least outlive the trace.  Each thread keeps at most
+  // MAXTRACEEVENTS spans; any more are counted and dropped.
+const long long MAXTRACEEVENTS = 4000000;
+void traceRecord(const char* name, long long startNanos, long long endNanos);
+
+  // Nanoseconds on the clock spans are measured with
+inline long long traceNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+  // Write every span recorded so far as a Chrome trace JSON file.  Call it
+  // only when no thread is still recording.  Returns false if the file
+  // couldn't be written.
+bool writeChromeTrace(const std::string& path);
+
+  // Forget every span recorded so far, and how many were dropped
+void clearTrace();
+long long droppedTraceEvents();
+
+  // Records the span from its construction to its destruction
+class TraceSpan
+{
+  public:
+    TraceSpan(const char* name) : m_name(name), m_start(traceNow()) {}
+    ~TraceSpan() { traceRecord(m_name, m_start, traceNow()); }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* m_name;
+    long long m_start;
+};
+
+#endif // TRACE_INCLUDED
@@ -0,0 +1,144 @@
+#include "Tuner.h"
+#include "Game.h"
+#include "globals.h"
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <mutex>
+
+using namespace std;
+
+namespace
+{
+    //Each tunable field, with the range it may take and how far one mutation
+    //moves it: by adding or subtracting step, or for a knob spanning several
+    //orders of magnitude, by multiplying or dividing by it
+    struct Knob
+    {
+        int GoodPlayerParams::* field;
+        const char* name;
+        int low;
+        int high;
+        int step;
+        bool logScale;
+    };
+
+    const Knob knobs[] = {
+        { &GoodPlayerParams::placementAttempts, "placementAttempts", 50, 2000000, 2, true },
+        { &GoodPlayerParams::shipSpacing,      "shipSpacing",      0,   6,  1, false },
+        { &GoodPlayerParams::parity,           "parity",           0,   1,  1, false },
+        { &GoodPlayerParams::parityRetries,    "parityRetries",    0, 200, 10, false },
+        { &GoodPlayerParams::alertRetries,     "alertRetries",     1, 200, 10, false },
+        { &GoodPlayerParams::alertRadius,      "alertRadius",      1,   4,  1, false },
+        { &GoodPlayerParams::alertGrowth,      "alertGrowth",      1,   3,  1, false },
+        { &GoodPlayerParams::searchRetries,    "searchRetries",    0, 100,  5, false },
+        { &GoodPlayerParams::searchMaxRadius,  "searchMaxRadius",  1,   6,  1, false },
+    };
+    const int nKnobs = sizeof(knobs) / sizeof(knobs[0]);
+
+    //Nudge each field up or down with probability 1/3, always changing at least one
+    GoodPlayerParams mutate(const GoodPlayerParams& parent, mt19937& rng)
+    {
+        GoodPlayerParams child = parent;
+        uniform_int_distribution<> third(0, 2);
+        uniform_int_distribution<> coin(0, 1);
+        bool changed = false;
+        while (!changed)
+        {
+            for (int k = 0; k < nKnobs; k++)
+            {
+                if (third(rng) != 0)
+                    continue;
+                const Knob& knob = knobs[k];
+                int value = child.*knob.field;
+                if (knob.logScale)
+                    value = (coin(rng) == 0 ? value / knob.step : value * knob.step);
+                else
+                    value += (coin(rng) == 0 ? -knob.step : knob.step);
+                if (value < knob.low)
+                    value = knob.low;
+                if (value > knob.high)
+                    value = knob.high;
+                if (value != child.*knob.field)
+                    changed = true;
+                child.*knob.field = value;
+            }
+        }
+        return child;
+    }
+
+    void writeHeader(ostream& out)
+    {
+        out << "generation,candidate,winRate";
+        for (int k = 0; k < nKnobs; k++)
+            out << ',' << knobs[k].name;
+        out << '\n';
+    }
+
+    void writeResult(ostream& out, int generation, int candidate, double winRate,
+                     const GoodPlayerParams& params)
+    {
+        out << generation << ',' << candidate << ',' << winRate;
+        for (int k = 0; k < nKnobs; k++)
+            out << ',' << params.*knobs[k].field;
+        out << endl;  //Flush, so the file is useful even if the run is cut short
+    }
+}
+
+double evaluateGoodPlayer(const GoodPlayerParams& params, const TuningOptions& options,
+                          unsigned long long seed)
+{
+    int nWins = 0;
+    for (int k = 0; k < options.gamesPerCandidate; k++)
+    {
+        seedRandom(gameSeed(seed, k));
+        Game g(options.rows, options.cols);
+        if (options.addShips != nullptr  &&  !options.addShips(g))
+            continue;
+        Player* good = createGoodPlayer("Tuned", g, params);
+        Player* other = createPlayer(options.opponent, "Opponent", g);
+        //Alternate who goes first, as main does
+        Player* winner = (k % 2 == 0 ? g.playQuietly(good, other) : g.playQuietly(other, good));
+        if (winner != nullptr  &&  winner == good)
+            nWins++;
+        delete good;
+        delete other;
+    }
+    return options.gamesPerCandidate > 0 ? double(nWins) / options.gamesPerCandidate : 0;
+}
+
+GoodPlayerParams tuneGoodPlayer(const TuningOptions& options)
+{
+    ofstream out(options.outputFile.c_str());
+    if (!out)
+        cout << "Cannot open " << options.outputFile << "; results won't be saved" << endl;
+    writeHeader(out);
+    mutex outMutex;
+
+    mt19937 rng(unsigned(options.seed));
+    GoodPlayerParams parent;
+    for (int gen = 0; gen < options.generations; gen++)
+    {
+        //Candidate 0 is the parent itself, re-evaluated on this generation's games
+        vector<GoodPlayerParams> candidates(1, parent);
+        while (int(candidates.size()) < options.populationSize)
+            candidates.push_back(mutate(parent, rng));
+
+        vector<double> winRates(candidates.size());
+        unsigned long long genSeed = gameSeed(options.seed, gen);
+        parallelFor(candidates.size(), options.nThreads, [&](long long i) {
+            winRates[i] = evaluateGoodPlayer(candidates[i], options, genSeed);
+            lock_guard<mutex> lock(outMutex);
+            writeResult(out, gen, int(i), winRates[i], candidates[i]);
+        });
+
+        size_t best = 0;
+        for (size_t i = 1; i < candidates.size(); i++)
+            if (winRates[i] > winRates[best])
+                best = i;
+        parent = candidates[best];
+        cout << "Generation " << gen << ": best win rate " << winRates[best] << endl;
+    }
+    return parent;
+}
@@ -0,0 +1,34 @@
+#ifndef TUNER_INCLUDED
+#define TUNER_INCLUDED
+
+#include "Player.h"
+#include "Tournament.h"
+#include <string>
+
+struct TuningOptions
+{
+    int rows = 10;
+    int cols = 10;
+    FleetSetup addShips = nullptr;
+    std::string opponent = "mediocre";  // createPlayer type to tune against
+    int generations = 20;
+    int populationSize = 16;            // candidates per generation, parent included
+    int gamesPerCandidate = 200;
+    int nThreads = 0;                   // 0 means one per hardware thread
+    unsigned long long seed = 1;
+    std::string outputFile = "tuning.csv";
+};
+
+  // Fraction of games a GoodPlayer with these parameters wins against the
+  // opponent, playing gamesPerCandidate games from the given seed
+double evaluateGoodPlayer(const GoodPlayerParams& params, const TuningOptions& options,
+                          unsigned long long seed);
+
+  // Evolve GoodPlayer's parameters against the opponent.  Every generation,
+  // the current best and mutations of it play the same set of games; the
+  // candidates are evaluated in parallel, each result is appended to the
+  // output file as soon as it's known, and the winner becomes the next
+  // generation's parent.  Returns the last parent.
+GoodPlayerParams tuneGoodPlayer(const TuningOptions& options);
+
+#endif // TUNER_INCLUDED
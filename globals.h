@@ -6,6 +6,7 @@
 
 const int MAXROWS = 10;
 const int MAXCOLS = 10;
+const int MAXSHIPS = MAXROWS * MAXCOLS;  // every ship takes at least one cell
 
 enum Direction {
     HORIZONTAL, VERTICAL
@@ -20,13 +21,28 @@ class Point
     int c;
 };
 
+  // The generator behind randInt.  Each thread has its own, so games can
+  // be played on several threads at once.
+inline std::mt19937& randomEngine()
+{
+    static thread_local std::random_device rd;
+    static thread_local std::mt19937 generator(rd());
+    return generator;
+}
+
+  // Restart the calling thread's random sequence, so that what it does
+  // from here on can be reproduced from the seed
+inline void seedRandom(unsigned long long seed)
+{
+    std::seed_seq seq{ unsigned(seed), unsigned(seed >> 32) };
+    randomEngine().seed(seq);
+}
+
   // Return a uniformly distributed random int from 0 to limit-1
 inline int randInt(int limit)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
     std::uniform_int_distribution<> distro(0, limit-1);
-    return distro(generator);
+    return distro(randomEngine());
 }
 
 #endif // GLOBALS_INCLUDED
@@ -1,7 +1,25 @@
 #include "Game.h"
 #include "Player.h"
+#include "Solver.h"
+#include "Tuner.h"
+#include "Tournament.h"
+#include "Stats.h"
+#include "Sprt.h"
+#include "League.h"
+#include "Spectator.h"
+#include "Batch.h"
+#include "Alloc.h"
+#include "Differential.h"
+#include "Replay.h"
+#include "Board.h"
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
 
 using namespace std;
 
@@ -14,16 +32,178 @@ bool addStandardShips(Game& g)
            g.addShip(2, 'P', "patrol boat");
 }
 
-int main()
+  // Run from the command line as
+  //   battleship shard <index> <count> <output file> [games]
+  // to play one shard of a good vs. mediocre match of that many games
+  // (default 100000), and as
+  //   battleship merge <shard file>...
+  // to combine the shards' results into the whole match's statistics, and
+  //   battleship batch <job spec>
+  // to run the match a job spec describes (see Batch.h), and
+  //   battleship verify [games]
+  // to check CompactBoard and the devirtualized game loop against Board and
+  // the virtual one, game by game (see Differential.h), and
+  //   battleship allocations
+  // to check that warmed-up games between computer players don't allocate
+  // while they play (only if compiled with BATTLESHIP_COUNT_ALLOCATIONS), and
+  //   battleship replay <replay file> <game>
+  // to play a recorded game (numbered from 0) again and show how it ended
+static int runCommand(int argc, char* argv[])
+{
+    string command = argv[1];
+    if (command == "allocations"  &&  argc == 2)
+    {
+        if (!allocationCountingCompiledIn())
+        {
+            cout << "Compile with BATTLESHIP_COUNT_ALLOCATIONS defined to count allocations"
+                 << endl;
+            return 1;
+        }
+        Game g(10, 10);
+        addStandardShips(g);
+        const char* types[] = { "awful", "mediocre", "good", "density", "good+endgame" };
+        int failures = 0;
+        for (const char* a : types)
+            for (const char* b : types)
+            {
+                long long n = steadyStateAllocations(g, a, b, 2, 20);
+                if (n != 0)
+                {
+                    cout << a << " vs. " << b << ": " << n << " allocations during play" << endl;
+                    failures++;
+                }
+            }
+        cout << (failures == 0 ? "No pairing allocated during play" : "Some pairings allocated")
+             << endl;
+        return failures == 0 ? 0 : 1;
+    }
+    if (command == "verify"  &&  (argc == 2  ||  argc == 3))
+    {
+        DifferentialOptions options;
+        options.match.addShips = addStandardShips;
+        options.match.nGames = (argc == 3 ? atoll(argv[2]) : 100000);
+        DifferentialResult result = runDifferential(options);
+        cout << "Checked " << result.gamesChecked << " games and " << result.shotsChecked
+             << " shots against the reference board" << endl;
+        if (!result.diverged)
+            return 0;
+        printDivergence(cout, result.first);
+        return 1;
+    }
+    if (command == "batch"  &&  argc == 3)
+    {
+        ifstream spec(argv[2]);
+        if (!spec)
+        {
+            cout << "Could not open " << argv[2] << endl;
+            return 1;
+        }
+        BatchJob job;
+        string error;
+        if (!readBatchJob(spec, job, error))
+        {
+            cout << argv[2] << ": " << error << endl;
+            return 1;
+        }
+        return runBatchJob(job, cout);
+    }
+    if (command == "shard"  &&  (argc == 5  ||  argc == 6))
+    {
+        MatchOptions options;
+        options.addShips = addStandardShips;
+        options.nGames = (argc == 6 ? atoll(argv[5]) : 100000);
+        options.shardIndex = atoi(argv[2]);
+        options.shardCount = atoi(argv[3]);
+        if (options.shardCount < 1  ||  options.shardIndex < 0  ||
+            options.shardIndex >= options.shardCount  ||  options.nGames < 0)
+        {
+            cout << "The shard index must be at least 0 and less than the count" << endl;
+            return 1;
+        }
+        MatchStats stats = runMatch(options);
+        if (!writeShardResult(argv[4], options, stats))
+        {
+            cout << "Could not write " << argv[4] << endl;
+            return 1;
+        }
+        cout << "Shard " << options.shardIndex << " of " << options.shardCount << ": "
+             << stats.games() << " games written to " << argv[4] << endl;
+        return 0;
+    }
+    if (command == "replay"  &&  argc == 4)
+    {
+        ReplayReader reader;
+        if (!reader.open(argv[2]))
+        {
+            cout << argv[2] << " is not a replay file" << endl;
+            return 1;
+        }
+        long long index = atoll(argv[3]);
+        if (index < 0  ||  index >= reader.nGames())
+        {
+            cout << argv[2] << " holds games 0 to " << reader.nGames() - 1 << endl;
+            return 1;
+        }
+        Game g(reader.rows(), reader.cols());
+        if (!reader.setUpGame(g))
+            return 1;
+        ReplayGame recorded = reader.game(index);
+        Board b1(g);
+        Board b2(g);
+        int winner = replayGame(recorded, b1, b2);
+        cout << "Game " << index << " (seed " << recorded.seed << "): " << recorded.nShots
+             << " shots; recorded winner " << recorded.winner << ", replayed winner "
+             << winner << endl;
+        for (int seat = 0; seat < 2; seat++)
+        {
+            cout << "Seat " << seat << "'s board:" << endl;
+            (seat == 0 ? b1 : b2).display(false);
+        }
+        return winner == recorded.winner ? 0 : 1;
+    }
+    if (command == "merge"  &&  argc >= 3)
+    {
+        vector<string> paths(argv + 2, argv + argc);
+        MatchStats stats;
+        string error;
+        if (!mergeShardResults(paths, stats, error))
+        {
+            cout << error << endl;
+            return 1;
+        }
+        stats.print(cout, "good", "mediocre", 5);
+        return 0;
+    }
+    cout << "Usage: " << argv[0] << " shard <index> <count> <output file> [games]" << endl;
+    cout << "       " << argv[0] << " merge <shard file>..." << endl;
+    cout << "       " << argv[0] << " batch <job spec>" << endl;
+    cout << "       " << argv[0] << " verify [games]" << endl;
+    cout << "       " << argv[0] << " allocations" << endl;
+    cout << "       " << argv[0] << " replay <replay file> <game>" << endl;
+    return 1;
+}
+
+int main(int argc, char* argv[])
 {
     const int NTRIALS = 50;
 
+    if (argc > 1)
+        return runCommand(argc, argv);
+
     cout << "Select one of these choices for an example of the game:" << endl;
     cout << "  1.  A mini-game between two mediocre players" << endl;
     cout << "  2.  A mediocre player against a human player" << endl;
     cout << "  3.  A " << NTRIALS
          << "-game match between a mediocre and an good player, with no pauses"
          << endl;
+    cout << "  4.  Exact solutions of small boards with one or two ships" << endl;
+    cout << "  5.  Tune the good player's parameters against a mediocre player"
+         << endl;
+    cout << "  6.  A good player against a mediocre player until one is clearly"
+         << " stronger" << endl;
+    cout << "  7.  A league of every computer player type, with ratings" << endl;
+    cout << "  8.  A good player against a mediocre player, watched through the"
+         << " spectator feed" << endl;
     cout << "Enter your choice: ";
     string line;
     getline(cin,line);
@@ -54,30 +234,137 @@ int main()
     }
     else if (line[0] == '3')
     {
-        int nMediocreWins = 0;
-
-        for (int k = 1; k <= NTRIALS; k++)
-        {
-            cout << "============================= Game " << k
-                 << " =============================" << endl;
-            Game g(10, 10);
-            addStandardShips(g);
-            Player* p1 = createPlayer("good", "God", g);
-            Player* p2 = createPlayer("mediocre", "Midori", g);
-            Player* winner = (k % 2 == 1 ?
-                                g.play(p1, p2, false) : g.play(p2, p1, false));
-            if (winner == p2)
-                nMediocreWins++;
-            delete p1;
-            delete p2;
-        }
-        cout << "The good player won " << NTRIALS - nMediocreWins << " out of "
+        MatchOptions options;
+        options.addShips = addStandardShips;
+        options.typeA = "good";
+        options.typeB = "mediocre";
+        options.nGames = NTRIALS;
+          // If an earlier run was interrupted, this picks up where it left
+          // off, at most 10 games back
+        options.checkpointPath = "match.checkpoint";
+        options.checkpointEvery = 10;
+        MatchStats stats = runMatch(options);
+        remove(options.checkpointPath.c_str());
+        cout << "The good player won " << stats.wins(0) << " out of "
              << NTRIALS << " games." << endl;
+        stats.print(cout, "God", "Midori", 5);
           // We'd expect a mediocre player to win most of the games against
           // an awful player.  Similarly, a good player should outperform
           // a mediocre player.
 		system("pause");
     }
+    else if (line[0] == '4')
+    {
+          // Solving gets expensive fast as the board grows; the solver gives
+          // up once it would need more than its state limit.
+        for (int n = 2; n <= 4; n++)
+        {
+            for (int nShips = 1; nShips <= 2; nShips++)
+            {
+                Game g(n, n + 1);
+                g.addShip(2, 'R', "rowboat");
+                if (nShips == 2)
+                    g.addShip(3, 'C', "canoe");
+                OptimalSolver solver(g, 100000, 500000);
+                cout << n << "x" << n + 1 << " board, " << nShips << " ship(s): ";
+                if (solver.solve())
+                    cout << solver.nLayouts() << " layouts, " << solver.nStates()
+                         << " states, " << solver.expectedShots()
+                         << " expected shots" << endl;
+                else
+                    cout << "too large to solve" << endl;
+            }
+        }
+    }
+    else if (line[0] == '5')
+    {
+        TuningOptions options;
+        options.addShips = addStandardShips;
+        GoodPlayerParams best = tuneGoodPlayer(options);
+        cout << "Best parameters found (all results are in " << options.outputFile
+             << "):" << endl;
+        cout << "  placementAttempts " << best.placementAttempts << endl;
+        cout << "  shipSpacing       " << best.shipSpacing << endl;
+        cout << "  parity            " << best.parity << endl;
+        cout << "  parityRetries     " << best.parityRetries << endl;
+        cout << "  alertRetries      " << best.alertRetries << endl;
+        cout << "  alertRadius       " << best.alertRadius << endl;
+        cout << "  alertGrowth       " << best.alertGrowth << endl;
+        cout << "  searchRetries     " << best.searchRetries << endl;
+        cout << "  searchMaxRadius   " << best.searchMaxRadius << endl;
+    }
+    else if (line[0] == '6')
+    {
+        SprtOptions options;
+        options.match.addShips = addStandardShips;
+        options.match.typeA = "good";
+        options.match.typeB = "mediocre";
+        options.match.nGames = 100000;
+        SprtResult result = runSprt(options);
+        if (result.decision == Sprt::A_STRONGER)
+            cout << "The good player is stronger";
+        else if (result.decision == Sprt::A_WEAKER)
+            cout << "The mediocre player is stronger";
+        else
+            cout << "No decision";
+        cout << " after " << result.gamesUsed << " games (log likelihood ratio "
+             << result.llr << ")." << endl;
+        result.stats.print(cout, "good", "mediocre", 5);
+    }
+    else if (line[0] == '7')
+    {
+        LeagueOptions options;
+        options.addShips = addStandardShips;
+        printLeague(cout, runLeague(options));
+    }
+    else if (line[0] == '8')
+    {
+        SpectatorFeed feed;
+        if (!feed.create("/battleship"))
+        {
+            cout << "Could not create the spectator feed." << endl;
+            return 1;
+        }
+        cout << "Publishing to /battleship; other programs can attach to it too." << endl;
+        MatchOptions options;
+        options.addShips = addStandardShips;
+        options.nGames = 1000;
+        options.spectators = &feed;
+
+          // Watch from another thread, as an outside monitor would
+        atomic<bool> done(false);
+        long long seen = 0, lost = 0, hits = 0, games = 0;
+        thread watcher([&]() {
+            SpectatorEvent event;
+            uint64_t next = 0;
+            for (;;)
+            {
+                bool finished = done;
+                for ( ; next < feed.published(); next++)
+                {
+                    if (!feed.read(next, event))
+                    {
+                        lost++;
+                        continue;
+                    }
+                    seen++;
+                    if (event.type == SpectatorEvent::SHOT  &&  event.shotHit)
+                        hits++;
+                    else if (event.type == SpectatorEvent::OVER)
+                        games++;
+                }
+                if (finished)
+                    break;
+                this_thread::yield();
+            }
+        });
+        MatchStats stats = runMatch(options);
+        done = true;
+        watcher.join();
+        stats.print(cout, "good", "mediocre", 5);
+        cout << "The watcher saw " << seen << " events (" << hits << " hits, " << games
+             << " games over) and missed " << lost << "." << endl;
+    }
     else
     {
        cout << "That's not one of the choices." << endl;